@@ -197,6 +197,8 @@ void GetContext(Document *doc, LINK contextL, short theStaff, PCONTEXT pContext)
 				foundTimeSig,
 				foundDynamic;
 
+	PROF_SCOPE("GetContext");
+
 	if (contextL==NILINK) {
 		MayErrMsg("GetContext: NILINK contextL, staff=%ld.", (long)theStaff);
 		return;
@@ -462,6 +462,19 @@ Document **pDoc)
 				PStrCat(doc->name, str);
 				doc->changed = doc->docNew = !readOnly;
 				doc->converted = True;
+
+				/* Check the converted score without interacting with the user, so any
+				   problems from conversion are in the log before it's edited or saved. */
+				
+				if (fileVersion=='N105') {
+					DCHECKRESULTS results;
+					
+					if (DCheckEverythingResults(doc, False, &results))
+						LogPrintf(LOG_ERR, "Converted score is too damaged to check.  (DoOpenDocumentX)\n");
+					else
+						LogPrintf(LOG_NOTICE, "Converted score: %d objects, %d problems found by %d checks.  (DoOpenDocumentX)\n",
+									results.nObjs, results.nErrors, results.nPasses);
+				}
 			}
 			else
 				doc->converted = False;
@@ -531,6 +544,7 @@ Boolean DoCloseDocument(Document *doc)
 					if (doc->undo.undoRecord) DisposeHandle(doc->undo.undoRecord);
 					doc->undo.undoRecord = NULL;
 					
+					InvalSysPicts(doc);
 					DestroyAllHeaps(doc);
 
 					doc->undo.hasUndo = False;
@@ -15,10 +15,26 @@
 #include "Nightingale_Prefix.pch"
 #include "Nightingale.appl.h"
 
+/* A display list for one System of the score, recorded as a QuickDraw picture. */
+
+typedef struct {
+	Document	*doc;
+	LINK		sysL;
+	Rect		paper;					/* Paper rect (local coords) it was recorded with */
+	Rect		sysRect;				/* The System's rect (local coords) then */
+	short		magnify;
+	PicHandle	picH;
+} SYSPICT;
+
 static void FrameSysRect(Rect *, Boolean);
 static void DrawMasterSystem(Document *, LINK, LINK, CONTEXT [], Rect *, Rect *, short);
 static void DrawMasterRange(Document *, LINK, LINK, CONTEXT [], Rect *, Rect *);
 static void DrawFormatRange(Document *, LINK, LINK, CONTEXT [], Rect *, Rect *);
+static SYSPICT *FindSysPict(Document *, LINK, Rect *);
+static void DisposeSysPict(SYSPICT *);
+static LINK SysPictEndL(LINK, LINK);
+static void BeginSysPict(Document *, LINK, LINK, Rect *, Rect *);
+static void EndSysPict(Boolean);
 static void DrawScoreRange(Document *, LINK, LINK, CONTEXT [], Rect *, Rect *);
 static void HiliteScoreRange(Document *, LINK, LINK, CONTEXT [], Rect *, Rect *);
 static void SetMusicPort(Document *);
@@ -346,25 +362,215 @@ grayPage:
 }
 
 
+/* ------------------------------------------------------------ System display lists -- */
+/* Drawing a System from the object list means re-deriving the position of every glyph,
+ledger line, beam and slur in it, and that's a lot of work to repeat every time part of
+the System is scrolled back into view. So while scrolling or redrawing the entire window,
+when DrawScoreRange draws an entire System to the screen because the update area covers
+all of it, it also records the drawing in a QuickDraw picture; and when the System comes
+back into view in those situations, it just draws the picture. The Inval routines
+discard the picture of any System they touch, and any other drawing of a System to the
+screen discards its picture too, since the System may have changed. */
+
+#define MAX_SYSPICTS 48							/* Max. no. of Systems to keep pictures of */
+
+static SYSPICT	sysPictTab[MAX_SYSPICTS];
+static short	nextSysPict = 0;				/* Slot to reuse next if all are full */
+static Boolean	sysPictUse = False;				/* Ok to record and replay pictures? */
+static Boolean	prerendering = False;			/* Drawing offscreen just to record pictures? */
+static Boolean	prerenderStopped = False;		/* ...and gave up because the user did something? */
+
+static short	recSysPict = -1;				/* Slot being recorded into, or -1 */
+static LINK		recEndL = NILINK;				/* End of the System being recorded */
+
+/* Allow or disallow recording Systems as pictures and drawing them from their pictures.
+QuickScroll allows it while it draws the newly-exposed parts of the window, and DoUpdate
+while it redraws the entire window. */
+
+void UseSysPicts(Boolean use)
+{
+	sysPictUse = use;
+}
+
+/* Bracket offscreen drawing whose only purpose is to record pictures of Systems, as
+PrerenderSheet does. Such drawing doesn't invalidate the hit index, since the window
+doesn't change, and it stops as soon as the user presses a key or clicks. EndPrerender
+returns False if it stopped. */
+
+void BeginPrerender(void)
+{
+	prerendering = sysPictUse = True;
+	prerenderStopped = False;
+}
+
+Boolean EndPrerender(void)
+{
+	prerendering = sysPictUse = False;
+	return !prerenderStopped;
+}
+
+static void DisposeSysPict(SYSPICT *pSysPict)
+{
+	if (pSysPict->picH) KillPicture(pSysPict->picH);
+	pSysPict->picH = NULL;
+	pSysPict->doc = NULL;
+	pSysPict->sysL = NILINK;
+}
+
+/* Discard the pictures of all Systems of <doc> or, if <doc> is NULL, of all documents. */
+
+void InvalSysPicts(Document *doc)
+{
+	short i;
+	
+	for (i = 0; i<MAX_SYSPICTS; i++)
+		if (i!=recSysPict && sysPictTab[i].picH && (doc==NULL || sysPictTab[i].doc==doc))
+			DisposeSysPict(&sysPictTab[i]);
+}
+
+/* Discard the picture of System <sysL> (in any document). */
+
+void InvalSysPict(LINK sysL)
+{
+	short i;
+	
+	for (i = 0; i<MAX_SYSPICTS; i++)
+		if (i!=recSysPict && sysPictTab[i].picH && sysPictTab[i].sysL==sysL)
+			DisposeSysPict(&sysPictTab[i]);
+}
+
+/* Discard the pictures of all Systems of <doc> that intersect <r>, in local coords. */
+
+void InvalSysPictsInRect(Document *doc, Rect *r)
+{
+	short i;
+	Rect result;
+	
+	for (i = 0; i<MAX_SYSPICTS; i++)
+		if (i!=recSysPict && sysPictTab[i].picH && sysPictTab[i].doc==doc
+		&&  SectRect(&sysPictTab[i].sysRect, r, &result))
+			DisposeSysPict(&sysPictTab[i]);
+}
+
+/* Return the picture of <sysL> if it was recorded with the current paper rect and
+magnification, else NULL. */
+
+static SYSPICT *FindSysPict(Document *doc, LINK sysL, Rect *paper)
+{
+	short i;
+	
+	for (i = 0; i<MAX_SYSPICTS; i++)
+		if (sysPictTab[i].picH && sysPictTab[i].doc==doc && sysPictTab[i].sysL==sysL) {
+			if (sysPictTab[i].magnify==doc->magnify && EqualRect(&sysPictTab[i].paper, paper))
+				return &sysPictTab[i];
+			return NULL;
+		}
+	return NULL;
+}
+
+/* Is there a picture of <sysL> that can be replayed with the current paper rect and
+magnification? */
+
+Boolean SysPictRecorded(Document *doc, LINK sysL, Rect *paper)
+{
+	return (FindSysPict(doc, sysL, paper)!=NULL);
+}
+
+/* If System <sysL> can be recorded while drawing a range that ends at <toL>, return
+the end of the System on its Page (the next System or Page, or the tail); else return
+NILINK. We require <toL> to be a structural boundary so the System can't be cut off. */
+
+static LINK SysPictEndL(LINK sysL, LINK toL)
+{
+	LINK pageL, nextSysL, endL;
+	
+	if (!PageTYPE(toL) && !SystemTYPE(toL) && !TailTYPE(toL)) return NILINK;
+	
+	pageL = SysPAGE(sysL);
+	nextSysL = LinkRSYS(sysL);
+	if (nextSysL && SysPAGE(nextSysL)==pageL) return nextSysL;
+	
+	endL = LinkRPAGE(pageL);
+	if (endL==NILINK) endL = toL;
+	return endL;
+}
+
+/* Start recording System <sysL> of <doc>, which ends at <endL> and occupies <sysRect>.
+The pen stays visible, so the System is drawn to the screen as it's recorded. */
+
+static void BeginSysPict(Document *doc, LINK sysL, LINK endL, Rect *paper,
+							Rect *sysRect)
+{
+	short i, slot;
+	PicHandle picH;
+	
+	InvalSysPict(sysL);
+	for (slot = -1, i = 0; i<MAX_SYSPICTS; i++)
+		if (!sysPictTab[i].picH) { slot = i; break; }
+	if (slot<0) {
+		slot = nextSysPict;
+		nextSysPict = (nextSysPict+1) % MAX_SYSPICTS;
+		DisposeSysPict(&sysPictTab[slot]);
+	}
+
+	picH = OpenPicture(paper);
+	if (!picH) return;
+	ShowPen();									/* OpenPicture hides it */
+
+	sysPictTab[slot].doc = doc;
+	sysPictTab[slot].sysL = sysL;
+	sysPictTab[slot].paper = *paper;
+	sysPictTab[slot].sysRect = *sysRect;
+	sysPictTab[slot].magnify = doc->magnify;
+	sysPictTab[slot].picH = picH;
+	recSysPict = slot;
+	recEndL = endL;
+}
+
+/* Finish recording the current System, and keep the picture if <keep>, else discard
+it. */
+
+static void EndSysPict(Boolean keep)
+{
+	SYSPICT *pSysPict;
+	
+	if (recSysPict<0) return;
+	pSysPict = &sysPictTab[recSysPict];
+	recSysPict = -1;
+	recEndL = NILINK;
+
+	HidePen();									/* ClosePicture shows it */
+	ClosePicture();
+	if (!keep || GetHandleSize((Handle)pSysPict->picH)<=0) DisposeSysPict(pSysPict);
+}
+
+
 static void DrawScoreRange(Document *doc, LINK fromL, LINK toL, CONTEXT context[],
 								Rect *paper, Rect *updateRect)
 {
-	LINK		pL, measL;
+	LINK		pL, measL, sysEndL;
 	PSYSTEM 	pSystem;
 	PMEASURE	pMeasure;
+	SYSPICT		*pSysPict;
+	EventRecord	event;
 	Rect 		r, result,
 				paperUpdate;			/* Paper-relative update rect */
 	Boolean		drawAll=True;			/* False if we're drawing only measure-spanning objects */
 	
+	PROF_SCOPE("DrawScoreRange");
+
 	paperUpdate = *updateRect;
 	OffsetRect(&paperUpdate, -paper->left, -paper->top);
 	
 	if (DETAIL_SHOW)
 		LogPrintf(LOG_DEBUG, "DrawScoreRange: fromL=%u toL=%u outputTo=%d\n", fromL, toL, outputTo);
 	
+	if (!prerendering) InvalHitIndex();				/* Drawing may recompute objRects */
+	
 	for (pL=fromL; pL!=toL; pL=RightLINK(pL))
 		switch (ObjLType(pL)) {
 			case PAGEtype:
+				if (pL==recEndL) EndSysPict(True);
 				/*
 				 * We have to find the first Measure after this Page to get context at
 				 *	in order to have a complete valid context before we get to drawing
@@ -379,6 +585,7 @@ static void DrawScoreRange(Document *doc, LINK fromL, LINK toL, CONTEXT context[
 				drawAll = True;
 				break;
 			case SYSTEMtype:
+				if (pL==recEndL) EndSysPict(True);
 				pSystem = GetPSYSTEM(pL);
 				
 				/* Convert systemRect to window-relative pixels, and check if it
@@ -388,6 +595,26 @@ static void DrawScoreRange(Document *doc, LINK fromL, LINK toL, CONTEXT context[
 				OffsetRect(&r, paper->left, paper->top);
 				if ((VISIBLE(pL) && SectRect(&r, updateRect, &result))
 													|| outputTo!=toScreen) {
+					/* If we're drawing to the screen while scrolling or redrawing the
+					   whole window, draw the System from its picture if we can;
+					   otherwise, if the update area covers the entire System, record
+					   a new picture as we draw it. Any other drawing of the System
+					   to the screen may mean it's changed, so discard its picture. */
+					   
+					sysEndL = (outputTo==toScreen? SysPictEndL(pL, toL) : NILINK);
+					if (sysEndL && sysPictUse) {
+						if ((pSysPict = FindSysPict(doc, pL, paper))!=NULL) {
+							DrawPicture(pSysPict->picH, &pSysPict->paper);
+							pL = LeftLINK(sysEndL);				/* Rewind for for loop above */
+							drawAll = True;
+							break;
+						}
+						UnionRect(&r, updateRect, &result);
+						if (EqualRect(&result, updateRect))
+							BeginSysPict(doc, pL, sysEndL, paper, &r);
+					}
+					else if (outputTo==toScreen)
+						InvalSysPict(pL);
 					DrawSYSTEM(doc, pL, paper, context);
 					if (doc->frameSystems) FrameSysRect(&r, False);	/* For debugging */
 				}
@@ -408,8 +635,15 @@ static void DrawScoreRange(Document *doc, LINK fromL, LINK toL, CONTEXT context[
 				if (VISIBLE(pL)) DrawCONNECT(doc, pL, context, TOPSYS_STAFF);	/* FIXME: BACKGROUND_STAFF?? */
 				break;
 			case MEASUREtype:
-				if (CheckZoom(doc)) return;				/* Each measure, look for zoom box hit */
-				if (DrawCheckInterrupt(doc)) return;	/* ...and for menu cmd key equivs. */
+				if (CheckZoom(doc) || DrawCheckInterrupt(doc)) {	/* Look for zoom box hit and */
+					EndSysPict(False);							/*   menu cmd key equivs. */
+					return;
+				}
+				if (prerendering && EventAvail(mDownMask+keyDownMask+autoKeyMask, &event)) {
+					prerenderStopped = True;			/* User wants attention: stop now */
+					EndSysPict(False);
+					return;
+				}
 				DrawMEASURE(doc, pL, context);
 				pMeasure = GetPMEASURE(pL);
 				if (SectRect(&pMeasure->measureBBox, &paperUpdate, &result)
@@ -498,6 +732,8 @@ static void DrawScoreRange(Document *doc, LINK fromL, LINK toL, CONTEXT context[
 			default:
 				;
 		}
+
+	if (recSysPict>=0) EndSysPict(pL==recEndL);
 }
 
 /*
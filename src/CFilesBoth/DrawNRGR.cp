@@ -857,7 +857,8 @@ the glyph to get the headwidth! the same goes for DrawMODNR and DrawRest. */
 		
 		/* First draw any accidental symbol to left of note */
 		
-		DrawAcc(doc, pContext, aNoteL, xdNorm, yd, dim, sizePercent, chordNoteToL);
+		if (!DRAW_LOWDETAIL(doc))
+			DrawAcc(doc, pContext, aNoteL, xdNorm, yd, dim, sizePercent, chordNoteToL);
 
 		/* If note is not a non-Main note in a chord, draw any ledger lines needed: for
 		   note or entire chord. A chord should have exactly one MainNote, so this will
@@ -1033,8 +1034,10 @@ the glyph to get the headwidth! the same goes for DrawMODNR and DrawRest. */
 					DrawNotehead(doc, glyph, appearance, dim, dhalfSp);
 			}
 
-			DrawModNR(doc, aNoteL, xd, pContext);
-			DrawAugDots(doc, aNoteL, xdNorm, yd, pContext, chordNoteToR);
+			if (!DRAW_LOWDETAIL(doc)) {
+				DrawModNR(doc, aNoteL, xd, pContext);
+				DrawAugDots(doc, aNoteL, xdNorm, yd, pContext, chordNoteToR);
+			}
 		}
 	
 		PenPat(NGetQDGlobalsBlack()); 				/* Restore full strength after possible dimming for "look" */
@@ -1443,8 +1446,10 @@ PushLock(NOTEheap);
 					MoveTo(xpLedg=xp-d2p(xledg),ypLedg=yp-d2p(yledg));
 					Line(d2p(LedgerLen(lnSpace)+LedgerOtherLen(lnSpace)),0);
 				}
-				DrawModNR(doc, aRestL, xd, pContext);					/* Draw all modifiers */
-				DrawAugDots(doc, aRestL, xd, ydNorm, pContext, False);
+				if (!DRAW_LOWDETAIL(doc)) {
+					DrawModNR(doc, aRestL, xd, pContext);				/* Draw all modifiers */
+					DrawAugDots(doc, aRestL, xd, ydNorm, pContext, False);
+				}
 	
 				/* If we're supposed to draw stemlets on beamed rests, do so. */
 				
@@ -1909,7 +1914,8 @@ glyph TO GET HEADWIDTH! THE SAME GOES FOR DrawMODNR AND DrawRest. */
 		
 		/* First draw any accidental symbol to left of grace note */
 
-		DrawGRAcc(doc, pContext, aGRNoteL, xdNorm, yd, dim, sizePercent);
+		if (!DRAW_LOWDETAIL(doc))
+			DrawGRAcc(doc, pContext, aGRNoteL, xdNorm, yd, dim, sizePercent);
 
 		/* If grace note is not a non-Main note in a chord, draw any ledger lines needed:
 		   for grace note or entire chord. A chord should have exactly one GRMainNote, so
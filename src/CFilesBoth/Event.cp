@@ -73,13 +73,21 @@ Boolean DoEvent()
 		if (haveEvent && !quitting) {
 			switch (theEvent.what) {
 				case mouseDown:
+					BeginInvalBatch();
+					SetHeapStatsCommand(HEAPSTATS_CLICK);
 					keepGoing = DoMouseDown(&theEvent);
+					SetHeapStatsCommand(HEAPSTATS_IDLE);
+					EndInvalBatch();
 					checkMemTime = 0L;								/* Check memory now */
 					checkDSTime = TickCount();						/* Check obj list after delay */
 					break;
 				case autoKey:
 				case keyDown:
+					BeginInvalBatch();
+					SetHeapStatsCommand(HEAPSTATS_KEY);
 					keepGoing = DoKeyDown(&theEvent);
+					SetHeapStatsCommand(HEAPSTATS_IDLE);
+					EndInvalBatch();
 					checkMemTime = 0L;								/* Check memory now */
 					checkDSTime = TickCount();						/* Check obj list after delay */
 					break;
@@ -204,6 +212,8 @@ static void DoNullEvent(EventRecord *evt)
 			if (doc) {					/* If TopDocument exists, use it to idle the caret */
 				if (doc != clipboard) {
 					if (!doc->overview && !doc->masterView) MEIdleCaret(doc);
+					if (!doc->overview && !doc->masterView && !doc->showFormat)
+						PrerenderSheets(doc);		/* Get neighboring pages ready to show */
 					}
 				}
 			}
@@ -215,8 +225,9 @@ the event is for. */
 void DoUpdate(WindowPtr w)
 	{
 		GrafPtr oldPort; 
-		Rect bBox;  Boolean doView;
+		Rect bBox, sysBox;  Boolean doView;
 		
+		FlushInvalBatch();							/* So this update includes it */
 		GetPort(&oldPort);  SetPort(GetWindowPort(w));
 		Document *doc, *topDoc;
 		
@@ -240,7 +251,16 @@ void DoUpdate(WindowPtr w)
 						InstallDoc(doc);
 						DrawDocumentControls(doc);
 						DrawMessageBox(doc, True);
-						if (doView) DrawDocumentView(doc, &bBox);
+						if (doView) {
+							/* When redrawing the whole view, Systems can be drawn from
+							   (and recorded as) pictures: anything that changed them
+							   has discarded their pictures via the Inval routines. */
+							   
+							UnionRect(&bBox, &doc->viewRect, &sysBox);
+							UseSysPicts(EqualRect(&sysBox, &bBox));
+							DrawDocumentView(doc, &bBox);
+							UseSysPicts(False);
+						}
 						topDoc = GetDocumentFromWindow(TopDocument);
 						if (topDoc!=NULL) InstallDoc(topDoc);
 					}
@@ -22,6 +22,7 @@
 /* Prototypes for internal functions: */
 
 static void SetTimeStamps(Document *);
+static void ResetOpenedScore(Document *);
 
 /* A version code is four characters, specifically 'N' followed by three digits, e.g.,
 'N105': N-one-zero-five. Be careful: It's not a valid C or Pascal string! */
@@ -42,6 +43,57 @@ static void SetTimeStamps(Document *doc)
 }
 
 
+/* ------------------------------------------------------------------ ResetOpenedScore -- */
+/* Assume that no information in the score having to do with window-relative positions
+is valid, and that nothing is selected. For every object in the main object list, clear
+the <valid> flag and set the objRect (and slur bounds) to empty, deselect it, and clear
+the tempFlags of its notes and grace notes; then set the selection to the default
+insertion point. This does the work of InvalRange, DeselAllNoHilite and SetTempFlags on
+the whole score in a single pass: for a very long score, touching each object and
+subobject once instead of three times is a noticeable part of the time to open it. */
+
+static void ResetOpenedScore(Document *doc)
+{
+	LINK	pL, aSlurL, aNoteL, aGRNoteL;
+	Rect	emptyRect;
+
+	InvalHitIndex();
+	InvalSysPicts(NULL);
+	SetRect(&emptyRect, 0, 0, 0, 0);
+
+	for (pL = doc->headL; pL!=doc->tailL; pL = RightLINK(pL)) {
+		LinkVALID(pL) = False;
+		LinkOBJRECT(pL) = emptyRect;
+		if (LinkSEL(pL)) DeselectNode(pL);		/* DeselectNode can't handle Pages, etc. */
+
+		switch (ObjLType(pL)) {
+			case SYNCtype:
+				aNoteL = FirstSubLINK(pL);
+				for ( ; aNoteL; aNoteL = NextNOTEL(aNoteL))
+					NoteTEMPFLAG(aNoteL) = False;
+				break;
+			case GRSYNCtype:
+				aGRNoteL = FirstSubLINK(pL);
+				for ( ; aGRNoteL; aGRNoteL = NextGRNOTEL(aGRNoteL))
+					GRNoteTEMPFLAG(aGRNoteL) = False;
+				break;
+			case SLURtype:
+				aSlurL = FirstSubLINK(pL);
+				for ( ; aSlurL; aSlurL = NextSLURL(aSlurL))
+					SlurBOUNDS(aSlurL) = emptyRect;
+				break;
+			default:
+				;
+		}
+	}
+
+	doc->hasCaret = False;									/* Caret must still be set up */
+	doc->selStartL = doc->headL;
+	doc->selEndL = doc->tailL;
+	SetDefaultSelection(doc);
+}
+
+
 /* -------------------------------------------------------------------------- OpenFile -- */
 
 static void VisifyAllNRGRs(Document *doc);
@@ -241,7 +293,7 @@ short OpenFile(Document *doc, unsigned char *filename, short vRefNum, FSSpec *pf
 	short 		errInfo=0,				/* Type of object being read or other info on error */
 				lastType;
 	long		count, stringPoolSize,
-				fileTime, fPos;
+				fileTime, fPos, startTicks, elapsedMS, nObjsConv;
 	Boolean		fileIsOpen;
 	FInfo		fInfo;
 	FSSpec 		fsSpec;
@@ -249,6 +301,7 @@ short OpenFile(Document *doc, unsigned char *filename, short vRefNum, FSSpec *pf
 	FSSpec		*pfsSpecMidiMap;
 	char		versionCString[5];
 
+	PROF_SCOPE("OpenFile");
 	WaitCursor();
 
 	fileIsOpen = False;
@@ -376,6 +429,7 @@ short OpenFile(Document *doc, unsigned char *filename, short vRefNum, FSSpec *pf
 	   the CPU's Endian property); then, if necessary, convert the heaps to the current
 	   object-list format. */
 	
+	startTicks = TickCount();
 	errType = ReadHeaps(doc, refNum, version, fInfo.fdType);
 	if (errType!=noErr) { errInfo = READHEAPScall; goto Error; }
 
@@ -392,6 +446,13 @@ short OpenFile(Document *doc, unsigned char *filename, short vRefNum, FSSpec *pf
 	if (version=='N105') {
 		(void)ConvertObjectList(doc, version, fileTime, False);
 		(void)ConvertObjectList(doc, version, fileTime, True);
+
+		/* Report conversion throughput, for comparing costs of migrating old files. */
+		
+		elapsedMS = TICKS2MS(TickCount()-startTicks);
+		nObjsConv = (doc->Heap+OBJtype)->nObjs-(doc->Heap+OBJtype)->nFree;
+		LogPrintf(LOG_NOTICE, "Read and converted %ld objects from 'N105' format in %ld ms (%ld objects/sec.).  (OpenFile)\n",
+					nObjsConv, elapsedMS, (elapsedMS>0? 1000L*nObjsConv/elapsedMS : nObjsConv*60L));
 #ifdef DEBUG_EMPTY_OBJRECT
 // The bug leading to the need for CheckNRGRVisibilityOK also caused empty objRects, so...
 for (LINK objL = 8; objL!=doc->tailL; objL = RightLINK(objL)) {
@@ -465,15 +526,9 @@ if (debugLevel[DBG_OPEN]!=0) {
 	/* Assume that no information in the score having to do with window-relative
 	   positions is valid. Besides clearing the object <valid> flags to indicate this,
 	   protect ourselves against functions that might not check the flags properly by
-	   setting all such positions to safe values now. */
+	   setting all such positions to safe values now. Also deselect everything. */
 	
-	InvalRange(doc->headL, doc->tailL);					/* Force computing all objRects */
-
-	doc->hasCaret = False;									/* Caret must still be set up */
-	doc->selStartL = doc->headL;							/* Set selection range */								
-	doc->selEndL = doc->tailL;								/*   to entire score, */
-	DeselAllNoHilite(doc);									/*   deselect it */
-	SetTempFlags(doc, doc, doc->headL, doc->tailL, False);	/* Just in case */
+	ResetOpenedScore(doc);
 
 	if (ScreenPagesExceedView(doc)) CautionInform(MANYPAGES_ALRT);
 
@@ -232,7 +232,10 @@ void Finalize()
 {
 	char bigOrLittleEndian;
 
-	if (!OpenPrefsFile()) return;			/* If it fails, there's nothing worth doing ??REALLY? */
+	if (!OpenPrefsFile()) {					/* If it fails, there's nothing worth doing ??REALLY? */
+		FlushLogPrintf();
+		return;
+	}
 	
 	if (!CheckUpdatePrefsFile()) LogPrintf(LOG_ERR, "Couldn't update the Nightingale Preferences file!  (Finalize)\n");
 
@@ -245,4 +248,5 @@ void Finalize()
 #endif
 	LogPrintf(LOG_NOTICE, "QUITTING NIGHTINGALE %s-%cE  (Finalize)\n", applVerStr,
 				bigOrLittleEndian);
+	FlushLogPrintf();
 }
@@ -38,7 +38,7 @@ static short WriteObject(short refNum, LINK pL);
 static short WriteSubobj(short refNum, short heapIndex, LINK pL);
 static void CountObjSubobjs(Document *doc);
 static Boolean InitTrackingLinks(Document *, LINK **firstSubLINKA, LINK **objA, LINK **modA);
-static Boolean MoveObjSubobjs(short, long, unsigned short, char *, long sizeAllInHeap);
+static Boolean MoveObjSubobjs(short, long, unsigned short, char *);
 static short ReadObjHeap(Document *doc, short refNum, long version, Boolean isViewerFile);
 static short ReadSubHeap(Document *doc, short refNum, long version, short iHp, Boolean isViewerFile);
 static short ReadHeapHdr(Document *doc, short refNum, long version, Boolean isViewerFile,
@@ -111,6 +111,8 @@ short WriteHeaps(Document *doc, short refNum)
 	const char *ps;
 	HEAP *myHeap;
 
+	PROF_SCOPE("WriteHeaps");
+
 	CountObjSubobjs(doc);
 	LogPrintf(LOG_INFO, "Objects and subobjects to be written:\n");
 	for (short iHp=FIRSTtype; iHp<LASTtype; iHp++ ) {
@@ -812,8 +814,9 @@ short ReadHeaps(Document *doc, short refNum, long version, OSType fdType)
 {
 	short iHp, errType=0;
 	Boolean isViewerFile;
-	LINK objL;
 		
+	PROF_SCOPE("ReadHeaps");
+
 	isViewerFile = (fdType==DOCUMENT_TYPE_VIEWER);
 
 	PrepareClips();
@@ -856,18 +859,13 @@ short ReadHeaps(Document *doc, short refNum, long version, OSType fdType)
 		}
 	}
 	else {
+		/* Subobjects were already handled a whole heap at a time by ReadSubHeap. */
+		
 		errType = HeapFixObjLinks(doc);
 		if (errType) {
 			MayErrMsg("HeapFixObjLinks failed (errType=%ld).  (ReadHeaps)", (long)errType);
 			return errType;
 		}
-
-//MAKE_A_FUSS("DEBUG_READHEAPS 5");
-
-		for (objL = doc->headL; objL!=doc->tailL; objL = RightLINK(objL))
-			EndianFixSubobjs(objL);
-		for (objL = doc->masterHeadL; objL!=doc->masterTailL; objL = RightLINK(objL))
-			EndianFixSubobjs(objL);
 	}
 	
 //MAKE_A_FUSS("DEBUG_READHEAPS 6");
@@ -883,69 +881,69 @@ we succeed, False if not.
 If the file is in the current format, this should be called only for the object heap;
 subobjects are already the correct length. If it's in 'N105' format, it should be
 called for both object and subobject heaps. In that case, the _content_ of objects
-and subobjects will still need more work, which should be done in ConvertObjectList().  */
+and subobjects will still need more work, which should be done in ConvertObjectList().
+
+The objects/subobjects were read in starting at LINK 1, so each one's new position is
+at or after its old position. We therefore move them in place, starting with the last
+one, so nothing is clobbered before it's moved. Subobjects in a heap are all the same
+length, so if that length hasn't changed there's nothing to move at all; but objects
+are variable-length, so we find where each one starts in a forward scan first. */
 
 static Boolean MoveObjSubobjs(short hType, long version, unsigned short nFObjs,
-								char *pLink1, long sizeAllInHeap)
+								char *pLink1)
 {
 #define NoDEBUG_LOOP
-#ifdef DEBUG_LOOP
-	static Boolean firstCall=True;
-#endif
-	char *src, *dst, *tempHeap;
+	long *srcOffset;
 	short curType;
-	long len, newLen, n;
+	long len, newLen, offset, n;
 
-	tempHeap = NewPtr((Size)sizeAllInHeap);
-	
-	/* Using if (!*tempHeap)... here misbehaves badly; I have no idea why!  --DAB, Oct. 2020 */
-	
-	if (!GoodNewPtr((Ptr)tempHeap))
-		{ OutOfMemory(sizeAllInHeap);  return False; }
-	BlockMove(pLink1, tempHeap, sizeAllInHeap);
+	if (hType!=OBJtype) {
+		len = (version=='N105'? subObjLength_5[hType] : subObjLength[hType]);
+		newLen = subObjLength[hType];
+		if (len==newLen) return True;
+		
+		if (len<newLen) {
+			for (n = nFObjs; n>=1; n--)
+				BlockMove(pLink1+(n-1)*len, pLink1+(n-1)*newLen, len);
+		}
+		else {
+			for (n = 1; n<=nFObjs; n++)
+				BlockMove(pLink1+(n-1)*len, pLink1+(n-1)*newLen, newLen);
+		}
+		return True;
+	}
+
+	srcOffset = (long *)NewPtr((Size)(nFObjs+1)*sizeof(long));
+	if (!GoodNewPtr((Ptr)srcOffset))
+		{ OutOfMemory((long)(nFObjs+1)*sizeof(long));  return False; }
+
+	/* Find where each object starts, checking its type as we go. */
 	
-	/* Copy everything to a separate chunk of memory, then copy objects/subobjects back
-	   one at a time, assuming the new sizes. */
-	   
-	src = tempHeap;
-	dst = pLink1;
-#ifdef DEBUG_LOOP
-	KludgeOS10p5LogDelay(True);					/* Avoid bug in OS 10.5/10.6 Console */
-#endif
+	offset = 0L;
 	for (n = 1; n<=nFObjs; n++) {
-		if (hType==OBJtype)	curType = ObjPtrTYPE(src);
-		else				curType = hType;
+		curType = ObjPtrTYPE(pLink1+offset);
 		if (curType<0 || curType>LASTtype) {
 			LogPrintf(LOG_ERR, "Object type=%d is illegal. hType=%d  (MoveObjSubobjs)\n", curType, hType);
+			DisposePtr((Ptr)srcOffset);
 			return False;
 		}
-		
-		/* Set <len> to the correct object/subobject length for the format of the given
-		   version and <newLen> to the length in the current version. */
+		srcOffset[n] = offset;
+		offset += (version=='N105'? objLength_5[curType] : objLength[curType]);
+	}
 
-		if (hType==OBJtype)	{
-			len = (version=='N105'? objLength_5[curType] : objLength[curType]);
-			newLen = sizeof(SUPEROBJECT);
-		}
-		else {
-			len = (version=='N105'? subObjLength_5[curType] : subObjLength[curType]);
-			newLen = subObjLength[curType];
-		}
-		
+	/* Copy each object, last first, to its anointed LINK slot. */
+	
+	newLen = sizeof(SUPEROBJECT);
+	for (n = nFObjs; n>=1; n--) {
+		len = (n<nFObjs? srcOffset[n+1] : offset)-srcOffset[n];
 #ifdef DEBUG_LOOP
-		LogPrintf(LOG_DEBUG, "MoveObjSubobjs: n=%d curType=%d src=%lx dst=%lxlen=%d newLen=%d\n",
-					n, curType, src, dst, len, newLen);
+		LogPrintf(LOG_DEBUG, "MoveObjSubobjs: n=%d src=%lx dst=%lx len=%d newLen=%d\n",
+					n, pLink1+srcOffset[n], pLink1+(n-1)*newLen, len, newLen);
 #endif
-		   
-		/* Copy obj/subobj of whatever type at <src> to its anointed LINK slot at <dst>,
-		   then go on to next obj/subobj and next LINK slot. */
-		
-		BlockMove(src, dst, len);
-		src += len;
-		dst += newLen;
+		BlockMove(pLink1+srcOffset[n], pLink1+(n-1)*newLen, len);
 	}
 	
-	DisposePtr((Ptr)tempHeap);
+	DisposePtr((Ptr)srcOffset);
 	return True;
 }
 
@@ -1020,7 +1018,7 @@ static short ReadObjHeap(Document *doc, short refNum, long version, Boolean isVi
 	/* Move the contents of the object heap around so each object has space for the
 	   required SUPEROBJECT size. */
 	   
-	if (!MoveObjSubobjs(OBJtype, version, nFObjs, pLink1, sizeAllObjsHeap)) {
+	if (!MoveObjSubobjs(OBJtype, version, nFObjs, pLink1)) {
 		OpenError(True, refNum, MISC_HEAPIO_ERR, OBJtype);
 		return(MISC_HEAPIO_ERR);
 	}
@@ -1112,7 +1110,7 @@ static short ReadSubHeap(Document *doc, short refNum, long version, short iHp, B
 #ifdef DEBUG_READHEAPS
 		if (iHp==SYNCtype) DSubobj5Dump(iHp, (unsigned char *)pLink1, 0, 1, True);
 #endif
-		if (!MoveObjSubobjs(iHp, version, nFObjs, pLink1, sizeAllInHeap)) {
+		if (!MoveObjSubobjs(iHp, version, nFObjs, pLink1)) {
 			OpenError(True, refNum, MISC_HEAPIO_ERR, iHp);
 			return MISC_HEAPIO_ERR;
 		}
@@ -1120,6 +1118,16 @@ static short ReadSubHeap(Document *doc, short refNum, long version, short iHp, B
 
 	PopLock(myHeap);
 	if (ioErr) { OpenError(True, refNum, ioErr, iHp); return ioErr; }
+
+	/* If the file is in the current format, handle the Endian issue for the entire
+	   heap at once: the subobjects we just read are exactly the ones in the file. (In
+	   'N105' format, there's no Endian issue; see ReadHeaps.) */
+	
+	if (version!='N105')
+		if (!EndianFixSubobjHeap(doc, iHp, nFObjs)) {
+			OpenError(True, refNum, MISC_HEAPIO_ERR, iHp);
+			return MISC_HEAPIO_ERR;
+		}
 	RebuildFreeList(doc, iHp, nFObjs);
 //if (DETAIL_SHOW) DHexDump(LOG_DEBUG, "ReadSubHeap3", (unsigned char *)pLink1, 78, 4, 16, False);
 	
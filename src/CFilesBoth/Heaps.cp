@@ -15,6 +15,41 @@
 
 #include "Nightingale_Prefix.pch"
 #include "Nightingale.appl.h"
+#include "SearchScorePrivate.h"
+
+static Boolean GrowHeapBlock(HEAP *heap, long deltaObjs);
+static LINK AllocFreshRun(HEAP *heap, unsigned short nObjs, long deltaObjs);
+static void NoteHeapEvent(HEAP *heap, short event, long nObjs);
+static void HeapStatsCmdName(long command, char *name);
+static void GetHeapAllocStats(long *pnAllocCalls, long *pnAllocObjs, long *pnFreshRuns,
+						long *pnGrowths, long *pnGrowObjs);
+
+/* Allocation statistics since launch, for each type of heap and for each command (menu
+command, or mouse click or keystroke that isn't one) during which allocation happened.
+See LogHeapStats. */
+
+typedef struct {
+	long			nAllocCalls, nAllocObjs;	/* Calls to HeapAlloc, and objects they got */
+	long			nFreeCalls, nFreeObjs;		/* Calls to HeapFree, and objects they freed */
+	long			nGrowths, nGrowObjs;		/* Times heap grew, and objects it grew by */
+	unsigned short	maxInUse;					/* High-water mark of objects in use in any one heap */
+	unsigned short	maxNObjs;					/* High-water mark of size of any one heap */
+} HEAPSTATS;
+
+typedef struct {
+	long			command;					/* Menu choice or HEAPSTATS_ code */
+	long			nAllocObjs, nFreeObjs, nGrowths;
+} CMDHEAPSTATS;
+
+#define MAX_CMDHEAPSTATS 64						/* Last entry is for all commands that don't fit */
+
+enum { HS_ALLOC, HS_FREE, HS_GROW };
+
+static HEAPSTATS	heapStats[LASTtype];
+static CMDHEAPSTATS	cmdHeapStats[MAX_CMDHEAPSTATS];
+static short		nCmdHeapStats = 0, curCmdHeapStats = -1;
+static long			curHeapStatsCmd = HEAPSTATS_IDLE;
+static long			nFreshRuns = 0L;
 
 /* This array gives the initial guess at the size, in objects, of each object/subobject
 heap.  These can be tweaked however is appropriate. */
@@ -157,39 +192,11 @@ Boolean ExpandFreeList(HEAP *heap,
 {
 	long newSize;  unsigned short i;
 	char *p, *p1stNew;
-	short err;
 	
 	if (deltaObjs<=0 || heap->objSize<=0) return(True);		/* Do nothing */
 	
-	/* Add space for deltaObjs objects at the end of this Heap's block, but don't allow
-	   too many objects: see comment above. */
-	   
+	if (!GrowHeapBlock(heap, deltaObjs)) return(False);
 	newSize = ((long)heap->nObjs) + deltaObjs;
-	if (newSize>=MAX_HEAPSIZE) {
-		char str[256];
-		
-		GetIndCString(str, ErrorStringsID, 16);	/* "The operation failed because the score requires more objects... */
-		CParamText(str, "", "", "");
-		StopInform(GENERIC_ALRT);
-		return(False);
-	}
-	
-	/* Temporarily unlock the data block, if necessary, and expand it. */
-	
-	if (heap->lockLevel != 0) {
-#define NoDEBUG_HEAPS
-#ifdef DEBUG_HEAPS
-/* FIXME: It seems a heap is often locked, but I haven't seen any problems result. Decide
-if it's really a problem (and fix it) or not (and remove this code)! */
-		MayErrMsg("Heap at %lx was locked (lockLevel=%ld). Unlocking it and proceeding.  (ExpandFreeList)",
-					heap, (long)heap->lockLevel);
-#endif
-		HUnlock(heap->block);
-	}
-	SetHandleSize(heap->block, newSize * heap->objSize);
-	err = MemError();
-	if (heap->lockLevel != 0) HLock(heap->block);
-	if (err) return(False);
 	
 	/* For all added objects but last, link object to following object. p will be left
 	   pointing to the last added object. */
@@ -236,16 +243,101 @@ if it's really a problem (and fix it) or not (and remove this code)! */
 }
 
 
+/* Make room for <deltaObjs> more objects at the end of <heap>'s block, but don't allow
+too many objects: see comment above. Doesn't touch the new objects, the free list, or
+heap->nObjs. */
+
+static Boolean GrowHeapBlock(HEAP *heap, long deltaObjs)
+{
+	long newSize;
+	short err;
+	
+	newSize = ((long)heap->nObjs) + deltaObjs;
+	if (newSize>=MAX_HEAPSIZE) {
+		char str[256];
+		
+		GetIndCString(str, ErrorStringsID, 16);	/* "The operation failed because the score requires more objects... */
+		CParamText(str, "", "", "");
+		StopInform(GENERIC_ALRT);
+		return(False);
+	}
+	
+	/* Temporarily unlock the data block, if necessary, and expand it. */
+	
+	if (heap->lockLevel != 0) {
+#define NoDEBUG_HEAPS
+#ifdef DEBUG_HEAPS
+/* FIXME: It seems a heap is often locked, but I haven't seen any problems result. Decide
+if it's really a problem (and fix it) or not (and remove this code)! */
+		MayErrMsg("Heap at %lx was locked (lockLevel=%ld). Unlocking it and proceeding.  (ExpandFreeList)",
+					heap, (long)heap->lockLevel);
+#endif
+		HUnlock(heap->block);
+	}
+	SetHandleSize(heap->block, newSize * heap->objSize);
+	err = MemError();
+	if (heap->lockLevel != 0) HLock(heap->block);
+	if (err) return(False);
+	
+	NoteHeapEvent(heap, HS_GROW, deltaObjs);
+	return(True);
+}
+
+
+/* Grow <heap> by <deltaObjs> objects and deliver the first <nObjs> of them as a list;
+the rest go on the free list. Since the new objects are a contiguous run, we can link
+each one once, directly into the list it belongs in, instead of putting them all on the
+free list and then walking it to snip off the ones we want. Deliver NILINK if there's
+no more memory. The heap must not be empty, since then the 0'th object would have to be
+skipped. */
+
+static LINK AllocFreshRun(HEAP *heap, unsigned short nObjs, long deltaObjs)
+{
+	LINK firstL, lastL, oldFirstFree, link;
+	char *p;
+	
+	if (!GrowHeapBlock(heap, deltaObjs)) return(NILINK);
+	
+	firstL = heap->nObjs;
+	lastL = firstL+deltaObjs-1;
+	oldFirstFree = heap->firstFree;
+	
+	p = (char *)(*heap->block);
+	p += (unsigned long)heap->objSize*(unsigned long)firstL;
+	for (link = firstL; link<lastL; link++) {
+		*(LINK *)p = link+1;
+		p += heap->objSize;
+	}
+	*(LINK *)p = oldFirstFree;								/* Rest of the run leads to old free list */
+	*(LINK *)LinkToPtr(heap, firstL+nObjs-1) = NILINK;		/* Terminate delivered list */
+	
+	if (deltaObjs>nObjs) heap->firstFree = firstL+nObjs;
+	heap->nFree += deltaObjs-nObjs;
+	heap->nObjs += deltaObjs;
+
+	nFreshRuns++;
+	return(firstL);
+}
+
+
 /* Deliver the index (LINK) of the first object of a linked list of nObjs objects from
 a given heap, or NILINK if no more memory or there's an error (nObjs not positive or
-objSize 0). */
+objSize 0).
+
+When the heap has to grow, it grows geometrically, i.e., by at least a fixed fraction of
+its current size, so a long series of allocations (e.g., merging or pasting thousands of
+notes) copies the block only a logarithmic number of times. The objects delivered then
+come from the newly-grown space, in a contiguous run. */
 
-#define GROWFACTOR 4		/* When more memory needed, get a chunk this many times as big */
+#define GROWFACTOR 4		/* When more memory needed, get a chunk at least this many times as big */
+#define GROWFRACTION 2		/* ...and at least 1/GROWFRACTION of the heap's current size */
 
 LINK HeapAlloc(HEAP *heap, unsigned short nObjs)
 {
 	LINK link, head;
 	char *p=NILINK, *start;
+	long deltaObjs;
+	unsigned short nLeft;
 	
 	if (nObjs <= 0) {
 		MayErrMsg("nObjs=%ld is illegal. heap=%ld  (HeapAlloc)", (long)nObjs, heap-Heap);
@@ -256,12 +348,25 @@ LINK HeapAlloc(HEAP *heap, unsigned short nObjs)
 		return(NILINK);
 	}
 	
-	/* Expand the free list, if necessary */
+	/* Expand the heap, if necessary. Normally we take the objects right out of the new
+	   space; but if the heap is empty or there isn't room for that many more objects,
+	   just add what we can to the free list. */
 	
 	if (nObjs > heap->nFree) {
 		if (DETAIL_SHOW) LogPrintf(LOG_DEBUG, "HeapAlloc before ExpandFreeList: heap=%lx ->nFree=%u nObjs=%u\n",
 									heap, heap->nFree, nObjs);
-		if (!ExpandFreeList(heap, GROWFACTOR*nObjs)) return(NILINK);
+		deltaObjs = (long)GROWFACTOR*nObjs;
+		if (deltaObjs<heap->nObjs/GROWFRACTION) deltaObjs = heap->nObjs/GROWFRACTION;
+		if ((long)heap->nObjs+deltaObjs>=MAX_HEAPSIZE) deltaObjs = MAX_HEAPSIZE-1L-heap->nObjs;
+
+		if (heap->nObjs>0 && deltaObjs>=nObjs) {
+			head = AllocFreshRun(heap, nObjs, deltaObjs);
+			if (head) NoteHeapEvent(heap, HS_ALLOC, nObjs);
+			return(head);
+		}
+
+		if (deltaObjs<(long)nObjs-heap->nFree) deltaObjs = (long)nObjs-heap->nFree;
+		if (!ExpandFreeList(heap, deltaObjs)) return(NILINK);
 	}
 		
 	/* Find the last of the first nObjs in the free list */
@@ -272,13 +377,14 @@ LINK HeapAlloc(HEAP *heap, unsigned short nObjs)
 	/* Snip first nObjs free objects from free list, and deliver head */
 	
 	heap->nFree -= nObjs;
-	while (nObjs-- > 0) {							/* Find the last object in snipped list */
+	for (nLeft = nObjs; nLeft>0; nLeft--) {		/* Find the last object in snipped list */
 		p = start + ((unsigned long)heap->objSize * (unsigned long)link);
 		link = *(LINK *)p;
 	}
 	*(LINK *)p = NILINK;							/* Terminate list */
 
 	heap->firstFree = link;							/* Reset the head of the free list */
+	NoteHeapEvent(heap, HS_ALLOC, nObjs);
 	return(head);
 }
 
@@ -309,6 +415,7 @@ LINK HeapFree(HEAP *heap, LINK head)
 		*(LINK *)p = heap->firstFree;
 		heap->firstFree = head;
 		heap->nFree += count;
+		NoteHeapEvent(heap, HS_FREE, count);
 	}
 
 	return(NILINK);
@@ -450,3 +557,725 @@ Boolean HeapLinkIsFree(HEAP *heap, LINK theLink)
 		
 	return False;
 }
+
+
+/* ================================================================= Heap statistics == */
+
+/* Record an allocation, free, or growth of <nObjs> objects in <heap>, both for its type
+of heap and for the current command. */
+
+static void NoteHeapEvent(HEAP *heap, short event, long nObjs)
+{
+	HEAPSTATS *hs;  CMDHEAPSTATS *cs;
+	unsigned short inUse;
+	
+	if (heap->type<FIRSTtype || heap->type>=LASTtype) return;
+	hs = &heapStats[heap->type];
+	
+	if (curCmdHeapStats<0) {
+		for (curCmdHeapStats = 0; curCmdHeapStats<nCmdHeapStats; curCmdHeapStats++)
+			if (cmdHeapStats[curCmdHeapStats].command==curHeapStatsCmd) break;
+		if (curCmdHeapStats>=nCmdHeapStats) {
+			if (nCmdHeapStats<MAX_CMDHEAPSTATS) nCmdHeapStats++;
+			else curCmdHeapStats = MAX_CMDHEAPSTATS-1;
+			cmdHeapStats[curCmdHeapStats].command = curHeapStatsCmd;
+		}
+	}
+	cs = &cmdHeapStats[curCmdHeapStats];
+
+	switch (event) {
+		case HS_ALLOC:
+			hs->nAllocCalls++;
+			hs->nAllocObjs += nObjs;
+			cs->nAllocObjs += nObjs;
+			inUse = heap->nObjs-1-heap->nFree;				/* 0'th object is never used */
+			if (inUse>hs->maxInUse) hs->maxInUse = inUse;
+			break;
+		case HS_FREE:
+			hs->nFreeCalls++;
+			hs->nFreeObjs += nObjs;
+			cs->nFreeObjs += nObjs;
+			break;
+		case HS_GROW:
+			hs->nGrowths++;
+			hs->nGrowObjs += nObjs;
+			cs->nGrowths++;
+			if ((long)heap->nObjs+nObjs>hs->maxNObjs) hs->maxNObjs = heap->nObjs+nObjs;
+			break;
+	}
+}
+
+
+/* Say what command subsequent heap activity should be charged to: a menu choice (as
+passed to DoMenu), or one of the HEAPSTATS_ codes. */
+
+void SetHeapStatsCommand(long command)
+{
+	if (command==curHeapStatsCmd) return;
+	curHeapStatsCmd = command;
+	curCmdHeapStats = -1;								/* Look it up when it's needed */
+}
+
+
+/* Deliver statistics on heap allocation since launch, totalled over all heaps: calls
+to HeapAlloc and the number of objects they asked for; how many of those calls were
+satisfied by a run of newly-grown space; and how many times heaps were grown, and by how
+many objects in all. */
+
+static void GetHeapAllocStats(long *pnAllocCalls, long *pnAllocObjs, long *pnFreshRuns,
+						long *pnGrowths, long *pnGrowObjs)
+{
+	short iHp;
+	
+	*pnAllocCalls = *pnAllocObjs = *pnGrowths = *pnGrowObjs = 0L;
+	for (iHp = FIRSTtype; iHp<LASTtype; iHp++) {
+		*pnAllocCalls += heapStats[iHp].nAllocCalls;
+		*pnAllocObjs += heapStats[iHp].nAllocObjs;
+		*pnGrowths += heapStats[iHp].nGrowths;
+		*pnGrowObjs += heapStats[iHp].nGrowObjs;
+	}
+	*pnFreshRuns = nFreshRuns;
+}
+
+
+/* Put a description of <command> into <name>, which must have room for 256 chars. */
+
+static void HeapStatsCmdName(long command, char *name)
+{
+	MenuHandle menuH;  Str255 itemStr;
+	
+	switch (command) {
+		case HEAPSTATS_IDLE:
+			strcpy(name, "(no command)");
+			return;
+		case HEAPSTATS_CLICK:
+			strcpy(name, "(mouse click)");
+			return;
+		case HEAPSTATS_KEY:
+			strcpy(name, "(keystroke)");
+			return;
+	}
+
+	menuH = GetMenuHandle(HiWord(command));
+	if (menuH==NULL) {
+		sprintf(name, "menu %d item %d", HiWord(command), LoWord(command));
+		return;
+	}
+	GetMenuItemText(menuH, LoWord(command), itemStr);
+	Pstrcpy((StringPtr)name, itemStr);
+	PToCString((StringPtr)name);
+}
+
+
+/* Write to the log the current state of each of <doc>'s heaps (if <doc> isn't NULL),
+and statistics on each type of heap, on all heaps together, and on each command since
+launch, plus the Inval batching counts (see BeginInvalBatch), since those too measure
+how much work editing commands cost. If <machineReadable>, write them as comma-separated
+values, one record per line with "HEAPSTATS" in the first field and the record type in
+the second, and a header line for each record type; otherwise, in a form that's easier
+for people to read. */
+
+void LogHeapStats(Document *doc, Boolean machineReadable)
+{
+	short iHp, i;  HEAP *heap;  HEAPSTATS *hs;  CMDHEAPSTATS *cs;
+	char cmdName[256];
+	const char *heapName;
+	long nAllocCalls, nAllocObjs, nFresh, nGrowths, nGrowObjs;
+	long nInvalRects, nInvalRedundant, nInvalFlushes;
+	
+	if (machineReadable) {
+		LogPrintf(LOG_INFO, "HEAPSTATS,heap,type,name,objSize,nObjs,nFree,allocCalls,allocObjs,freeCalls,freeObjs,growths,growObjs,maxInUse,maxNObjs\n");
+		LogPrintf(LOG_INFO, "HEAPSTATS,total,allocCalls,allocObjs,freshRuns,growths,growObjs\n");
+		LogPrintf(LOG_INFO, "HEAPSTATS,command,menuID,item,name,allocObjs,freeObjs,growths\n");
+		LogPrintf(LOG_INFO, "HEAPSTATS,inval,rects,redundant,flushes\n");
+	}
+	else
+		LogPrintf(LOG_INFO, "Heap statistics since launch%s:\n", (doc? " and current state" : ""));
+
+	for (iHp = FIRSTtype; iHp<LASTtype; iHp++) {
+		hs = &heapStats[iHp];
+		heap = (doc? doc->Heap+iHp : NULL);
+		if (hs->nAllocCalls==0L && hs->nGrowths==0L && (heap==NULL || heap->nObjs==0)) continue;
+		heapName = NameHeapType(iHp, False);
+		if (machineReadable)
+			LogPrintf(LOG_INFO, "HEAPSTATS,heap,%d,%s,%d,%u,%u,%ld,%ld,%ld,%ld,%ld,%ld,%u,%u\n",
+						iHp, heapName, (heap? heap->objSize : 0), (heap? heap->nObjs : 0),
+						(heap? heap->nFree : 0), hs->nAllocCalls, hs->nAllocObjs,
+						hs->nFreeCalls, hs->nFreeObjs, hs->nGrowths, hs->nGrowObjs,
+						hs->maxInUse, hs->maxNObjs);
+		else {
+			if (heap)
+				LogPrintf(LOG_INFO, "  %2d %-10s objSize=%d: %u objects, %u free, %u in use\n",
+							iHp, heapName, heap->objSize, heap->nObjs, heap->nFree,
+							(heap->nObjs>0? heap->nObjs-1-heap->nFree : 0));
+			else
+				LogPrintf(LOG_INFO, "  %2d %-10s\n", iHp, heapName);
+			LogPrintf(LOG_INFO, "       alloc %ld calls/%ld objs, free %ld/%ld, grew %ld times/%ld objs, max %u in use of %u\n",
+						hs->nAllocCalls, hs->nAllocObjs, hs->nFreeCalls, hs->nFreeObjs,
+						hs->nGrowths, hs->nGrowObjs, hs->maxInUse, hs->maxNObjs);
+		}
+	}
+	
+	GetHeapAllocStats(&nAllocCalls, &nAllocObjs, &nFresh, &nGrowths, &nGrowObjs);
+	if (machineReadable)
+		LogPrintf(LOG_INFO, "HEAPSTATS,total,%ld,%ld,%ld,%ld,%ld\n", nAllocCalls, nAllocObjs,
+					nFresh, nGrowths, nGrowObjs);
+	else
+		LogPrintf(LOG_INFO, "  All heaps: alloc %ld calls/%ld objs, %ld calls got newly-grown space, grew %ld times/%ld objs\n",
+					nAllocCalls, nAllocObjs, nFresh, nGrowths, nGrowObjs);
+	
+	if (!machineReadable) LogPrintf(LOG_INFO, "Heap activity by command since launch:\n");
+	for (i = 0; i<nCmdHeapStats; i++) {
+		cs = &cmdHeapStats[i];
+		if (i==MAX_CMDHEAPSTATS-1 && nCmdHeapStats==MAX_CMDHEAPSTATS)
+			strcpy(cmdName, "(all other commands)");
+		else
+			HeapStatsCmdName(cs->command, cmdName);
+		if (machineReadable)
+			LogPrintf(LOG_INFO, "HEAPSTATS,command,%d,%d,\"%s\",%ld,%ld,%ld\n",
+						HiWord(cs->command), LoWord(cs->command), cmdName,
+						cs->nAllocObjs, cs->nFreeObjs, cs->nGrowths);
+		else
+			LogPrintf(LOG_INFO, "  %-32s alloc %ld objs, free %ld, net %ld, grew heaps %ld times\n",
+						cmdName, cs->nAllocObjs, cs->nFreeObjs, cs->nAllocObjs-cs->nFreeObjs,
+						cs->nGrowths);
+	}
+
+	GetInvalBatchStats(&nInvalRects, &nInvalRedundant, &nInvalFlushes);
+	if (machineReadable)
+		LogPrintf(LOG_INFO, "HEAPSTATS,inval,%ld,%ld,%ld\n", nInvalRects, nInvalRedundant,
+					nInvalFlushes);
+	else
+		LogPrintf(LOG_INFO, "Inval batching since launch: %ld rects requested, %ld already covered, %ld Window Manager calls\n",
+					nInvalRects, nInvalRedundant, nInvalFlushes);
+}
+
+
+/* ============================================================== Heap compaction == */
+/* After heavy editing, HeapAlloc's LIFO free lists leave consecutive objects, and the
+subobjects of each object, scattered all over their heaps, so every traversal of the
+object list jumps around in memory. CompactHeaps renumbers the object heap and every
+subobject heap so that their records are in the same order as the object lists, and
+rewrites every LINK that refers to them. The in-use records end up at the beginning of
+each heap, in order, and the free records after them.
+
+The only LINKs CompactHeaps knows how to fix are those in the object lists (main, Master
+Page, and Undo) and in the Document; anything else that's holding onto LINKs must be
+invalidated or rebuilt afterwards, as the hit index, System pictures, and Search result
+list are here. So it should be called only at "top level", not in the middle of an
+operation, and not while the Master Page or Work on Format is active. For safety, it's
+only done on request (Option + Heap Browser), not automatically. */
+
+#define MAP_LINK(map, mapSize, link)	( (link)<(mapSize)? (map)[link] : NILINK )
+
+static long HeapListOrder(Document *doc, short iHp, LINK *order, LINK *map);
+static long HeapScatter(LINK *order, long n);
+static Boolean PermuteHeap(HEAP *heap, LINK *order, long n);
+static void RebuildHeapFreeList(HEAP *heap, long nUsed);
+static void RemapObjLinks(LINK pL, LINK *objMap, unsigned short nObjMap);
+static void RemapSubobjLinks(Document *doc, short iHp, long n, LINK *map, LINK *objMap,
+					unsigned short nObjMap);
+
+
+/* Fill <order> with the LINKs of all the records in use in heap <iHp>, in the order
+they're encountered in traversing the main object list, the Master Page object list, and
+the Undo object list; for subobject heaps, in the order of the objects they belong to.
+<map> must be all NILINK on entry; on exit, map[oldL] is the LINK record oldL will have
+after compaction, i.e., its position in <order> plus one. Return the number of records
+found, or -1 if the lists are too badly damaged to traverse (a LINK out of range, or the
+same record reached twice). */
+
+#define ADD_TO_ORDER(link)	{ if ((link)>=heap->nObjs || map[link]!=NILINK) return -1L;	\
+							  order[n] = (link);  n++;  map[link] = n; }
+
+static long HeapListOrder(Document *doc, short iHp, LINK *order, LINK *map)
+{
+	LINK	headL[3], tailL[3], pL, subL, aNoteL;
+	HEAP	*heap = doc->Heap+iHp;
+	long	n = 0L, nVisited = 0L;
+	short	i;
+	
+	headL[0] = doc->headL;			tailL[0] = doc->tailL;
+	headL[1] = doc->masterHeadL;	tailL[1] = doc->masterTailL;
+	headL[2] = doc->undo.headL;		tailL[2] = doc->undo.tailL;
+	
+	for (i = 0; i<3; i++) {
+		if (headL[i]==NILINK) continue;
+		for (pL = headL[i]; ; pL = RightLINK(pL)) {
+			if (pL==NILINK || pL>=OBJheap->nObjs || ++nVisited>OBJheap->nObjs) return -1L;
+			
+			if (iHp==OBJtype)
+				ADD_TO_ORDER(pL)
+			else if (iHp==MODNRtype) {
+				if (ObjLType(pL)==SYNCtype)
+					for (aNoteL = FirstSubLINK(pL); aNoteL; aNoteL = NextNOTEL(aNoteL)) {
+						if (aNoteL>=SYNCheap->nObjs) return -1L;
+						for (subL = NoteFIRSTMOD(aNoteL); subL; subL = NextMODNRL(subL))
+							ADD_TO_ORDER(subL);
+					}
+			}
+			else if (ObjLType(pL)==iHp) {
+				for (subL = FirstSubLINK(pL); subL; subL = NextLink(heap, subL))
+					ADD_TO_ORDER(subL);
+			}
+
+			if (pL==tailL[i]) break;
+		}
+	}
+	
+	return n;
+}
+
+
+/* Return the number of places in <order> where a record isn't followed by the record
+right after it in its heap: our measure of how badly a heap is fragmented. */
+
+static long HeapScatter(LINK *order, long n)
+{
+	long k, nScattered = 0L;
+	
+	for (k = 1; k<n; k++)
+		if (order[k]!=order[k-1]+1) nScattered++;
+	
+	return nScattered;
+}
+
+
+/* Replace <heap>'s block with a new one of the same size, in which record k+1 is a copy
+of record order[k] of the old block, and rebuild its free list from the records that are
+left. If the records are already in that order, just leave the heap alone. Return False
+if we can't get the memory for the new block, in which case the heap is unchanged. */
+
+static Boolean PermuteHeap(HEAP *heap, LINK *order, long n)
+{
+	Handle newBlock;  char *src, *dst;
+	long k;
+	
+	for (k = 0; k<n; k++)
+		if (order[k]!=k+1) break;
+	if (k>=n) return True;									/* Already compact */
+	
+	newBlock = NewHandle(GetHandleSize(heap->block));
+	if (!GoodNewHandle(newBlock)) return False;
+	
+	src = (char *)(*heap->block);
+	dst = (char *)(*newBlock);
+	for (k = 0; k<n; k++)
+		BlockMoveData(src+(unsigned long)heap->objSize*(unsigned long)order[k],
+						dst+(unsigned long)heap->objSize*(unsigned long)(k+1), heap->objSize);
+
+	DisposeHandle(heap->block);
+	heap->block = newBlock;
+	if (heap->lockLevel != 0) HLock(heap->block);
+	
+	RebuildHeapFreeList(heap, n);
+	return True;
+}
+
+
+/* Make all records in <heap> after the first <nUsed> (not counting the 0'th, which is
+never used) into its free list, in order. */
+
+static void RebuildHeapFreeList(HEAP *heap, long nUsed)
+{
+	char *p;  unsigned short i;
+	
+	if (nUsed+1>=heap->nObjs) {
+		heap->firstFree = NILINK;
+		heap->nFree = 0;
+		return;
+	}
+	
+	p = (char *)(*heap->block);
+	p += (unsigned long)heap->objSize*(unsigned long)(nUsed+1);
+	for (i = nUsed+1; i<heap->nObjs-1; i++) {
+		*(LINK *)p = i+1;
+		p += heap->objSize;
+	}
+	*(LINK *)p = NILINK;
+	
+	heap->firstFree = nUsed+1;
+	heap->nFree = heap->nObjs-1-nUsed;
+}
+
+
+/* Convert the links in object <pL> to other objects, including the hidden links between
+Pages, Systems, Staffs and Measures, with <objMap>. Cf. WriteObjHeap and HeapFixObjLinks,
+which do similar things when writing and reading files. */
+
+static void RemapObjLinks(LINK pL, LINK *objMap, unsigned short nObjMap)
+{
+	LeftLINK(pL) = MAP_LINK(objMap, nObjMap, LeftLINK(pL));
+	RightLINK(pL) = MAP_LINK(objMap, nObjMap, RightLINK(pL));
+
+	switch (ObjLType(pL)) {
+		case PAGEtype:
+			LinkLPAGE(pL) = MAP_LINK(objMap, nObjMap, LinkLPAGE(pL));
+			LinkRPAGE(pL) = MAP_LINK(objMap, nObjMap, LinkRPAGE(pL));
+			break;
+		case SYSTEMtype:
+			LinkLSYS(pL) = MAP_LINK(objMap, nObjMap, LinkLSYS(pL));
+			LinkRSYS(pL) = MAP_LINK(objMap, nObjMap, LinkRSYS(pL));
+			SysPAGE(pL) = MAP_LINK(objMap, nObjMap, SysPAGE(pL));
+			break;
+		case STAFFtype:
+			LinkLSTAFF(pL) = MAP_LINK(objMap, nObjMap, LinkLSTAFF(pL));
+			LinkRSTAFF(pL) = MAP_LINK(objMap, nObjMap, LinkRSTAFF(pL));
+			StaffSYS(pL) = MAP_LINK(objMap, nObjMap, StaffSYS(pL));
+			break;
+		case MEASUREtype:
+			LinkLMEAS(pL) = MAP_LINK(objMap, nObjMap, LinkLMEAS(pL));
+			LinkRMEAS(pL) = MAP_LINK(objMap, nObjMap, LinkRMEAS(pL));
+			MeasSYSL(pL) = MAP_LINK(objMap, nObjMap, MeasSYSL(pL));
+			MeasSTAFFL(pL) = MAP_LINK(objMap, nObjMap, MeasSTAFFL(pL));
+			break;
+		case SLURtype:
+			SlurFIRSTSYNC(pL) = MAP_LINK(objMap, nObjMap, SlurFIRSTSYNC(pL));
+			SlurLASTSYNC(pL) = MAP_LINK(objMap, nObjMap, SlurLASTSYNC(pL));
+			break;
+		case DYNAMtype:
+			DynamFIRSTSYNC(pL) = MAP_LINK(objMap, nObjMap, DynamFIRSTSYNC(pL));
+			if (IsHairpin(pL))
+				DynamLASTSYNC(pL) = MAP_LINK(objMap, nObjMap, DynamLASTSYNC(pL));
+			break;
+		case GRAPHICtype:
+			GraphicFIRSTOBJ(pL) = MAP_LINK(objMap, nObjMap, GraphicFIRSTOBJ(pL));
+			if (GraphicSubType(pL)==GRDraw)
+				GraphicLASTOBJ(pL) = MAP_LINK(objMap, nObjMap, GraphicLASTOBJ(pL));
+			break;
+		case TEMPOtype:
+			TempoFIRSTOBJ(pL) = MAP_LINK(objMap, nObjMap, TempoFIRSTOBJ(pL));
+			break;
+		case ENDINGtype:
+			EndingFIRSTOBJ(pL) = MAP_LINK(objMap, nObjMap, EndingFIRSTOBJ(pL));
+			EndingLASTOBJ(pL) = MAP_LINK(objMap, nObjMap, EndingLASTOBJ(pL));
+			break;
+		case RPTENDtype:
+			RptEndFIRSTOBJ(pL) = MAP_LINK(objMap, nObjMap, RptEndFIRSTOBJ(pL));
+			RptEndSTARTRPT(pL) = MAP_LINK(objMap, nObjMap, RptEndSTARTRPT(pL));
+			RptEndENDRPT(pL) = MAP_LINK(objMap, nObjMap, RptEndENDRPT(pL));
+			break;
+		default:
+			break;
+	}
+}
+
+
+/* Convert the links in the first <n> records of subobject heap <iHp>, which has just
+been compacted with <map>: their <next> links, and links to objects. Then convert the
+links to them from their owners: the firstSubObj links of objects, or, for note
+modifiers, the firstMod links of notes. */
+
+static void RemapSubobjLinks(Document *doc, short iHp, long n, LINK *map, LINK *objMap,
+					unsigned short nObjMap)
+{
+	HEAP	*heap = doc->Heap+iHp;
+	LINK	subL, pL, aNoteL, headL[3], tailL[3];
+	short	i;
+	
+	for (subL = 1; subL<=n; subL++) {
+		*(LINK *)LinkToPtr(heap, subL) = map[NextLink(heap, subL)];
+		switch (iHp) {
+			case BEAMSETtype:
+				(GetPANOTEBEAM(subL))->bpSync =
+						MAP_LINK(objMap, nObjMap, (GetPANOTEBEAM(subL))->bpSync);
+				break;
+			case TUPLETtype:
+				(GetPANOTETUPLE(subL))->tpSync =
+						MAP_LINK(objMap, nObjMap, (GetPANOTETUPLE(subL))->tpSync);
+				break;
+			case OTTAVAtype:
+				(GetPANOTEOTTAVA(subL))->opSync =
+						MAP_LINK(objMap, nObjMap, (GetPANOTEOTTAVA(subL))->opSync);
+				break;
+			default:
+				break;
+		}
+	}
+
+	headL[0] = doc->headL;			tailL[0] = doc->tailL;
+	headL[1] = doc->masterHeadL;	tailL[1] = doc->masterTailL;
+	headL[2] = doc->undo.headL;		tailL[2] = doc->undo.tailL;
+	
+	for (i = 0; i<3; i++) {
+		if (headL[i]==NILINK) continue;
+		for (pL = headL[i]; pL; pL = RightLINK(pL)) {
+			if (iHp==MODNRtype) {
+				if (ObjLType(pL)==SYNCtype)
+					for (aNoteL = FirstSubLINK(pL); aNoteL; aNoteL = NextNOTEL(aNoteL))
+						NoteFIRSTMOD(aNoteL) = map[NoteFIRSTMOD(aNoteL)];
+			}
+			else if (ObjLType(pL)==iHp)
+				FirstSubLINK(pL) = map[FirstSubLINK(pL)];
+			if (pL==tailL[i]) break;
+		}
+	}
+}
+
+
+/* Compact all of <doc>'s heaps, as described above; <doc>'s heaps must be installed.
+Log how fragmented the heaps were before and after, heap by heap if <showDetail>. Return
+True if all went well. If there's a problem, the heaps compacted so far stay that way, and
+those not yet compacted are unchanged: either way the data structure is still valid. */
+
+Boolean CompactHeaps(Document *doc, Boolean showDetail)
+{
+	LINK	*order=NULL, *map=NULL, *objMap=NULL, pL;
+	unsigned short nObjMap, maxObjs;
+	long	n, nLive[LASTtype], nBefore[LASTtype], nAfter[LASTtype], totBefore, totAfter;
+	short	iHp, h, nHeaps, heapOrder[LASTtype];
+	HEAP	*heap;
+	Boolean	okay = False;
+	
+	if (doc==NULL || doc==clipboard || doc->masterView || doc->showFormat) return False;
+
+	nObjMap = OBJheap->nObjs;
+	for (maxObjs = 0, iHp = FIRSTtype; iHp<LASTtype; iHp++)
+		if (doc->Heap[iHp].nObjs>maxObjs) maxObjs = doc->Heap[iHp].nObjs;
+	
+	order = (LINK *)NewPtr((Size)(maxObjs+1)*sizeof(LINK));
+	map = (LINK *)NewPtr((Size)(maxObjs+1)*sizeof(LINK));
+	objMap = (LINK *)NewPtr((Size)(nObjMap+1)*sizeof(LINK));
+	if (!order || !map || !objMap) {
+		LogPrintf(LOG_WARNING, "Not enough memory to compact heaps.  (CompactHeaps)\n");
+		goto Done;
+	}
+	FillMem(0, objMap, (nObjMap+1)*sizeof(LINK));
+
+	for (iHp = FIRSTtype; iHp<LASTtype; iHp++)
+		nLive[iHp] = nBefore[iHp] = nAfter[iHp] = 0L;
+
+	/* First the object heap, since the order of all the subobject heaps depends on the
+	   order of the objects. Then the note modifier heap, since its order depends on the
+	   current order of the Sync heap. Then the rest. */
+	
+	nHeaps = 0;
+	heapOrder[nHeaps++] = OBJtype;
+	heapOrder[nHeaps++] = MODNRtype;
+	for (iHp = FIRSTtype; iHp<LASTtype; iHp++)
+		if (iHp!=OBJtype && iHp!=MODNRtype) heapOrder[nHeaps++] = iHp;
+
+	for (h = 0; h<nHeaps; h++) {
+		iHp = heapOrder[h];
+		heap = doc->Heap+iHp;
+		if (heap->objSize<=0 || heap->nObjs==0) continue;
+		
+		FillMem(0, map, (maxObjs+1)*sizeof(LINK));
+		n = HeapListOrder(doc, iHp, order, (iHp==OBJtype? objMap : map));
+		if (n<0L) {
+			LogPrintf(LOG_ERR, "Heap %d (%s) is damaged: can't compact it.  (CompactHeaps)\n",
+						iHp, NameHeapType(iHp, False));
+			goto Done;
+		}
+		nLive[iHp] = n;
+		nBefore[iHp] = HeapScatter(order, n);
+		if (!PermuteHeap(heap, order, n)) {
+			LogPrintf(LOG_WARNING, "Not enough memory to compact heap %d (%s).  (CompactHeaps)\n",
+						iHp, NameHeapType(iHp, False));
+			goto Done;
+		}
+		
+		if (iHp==OBJtype) {
+			for (pL = 1; pL<=nLive[OBJtype]; pL++)
+				RemapObjLinks(pL, objMap, nObjMap);
+			doc->headL = MAP_LINK(objMap, nObjMap, doc->headL);
+			doc->tailL = MAP_LINK(objMap, nObjMap, doc->tailL);
+			doc->selStartL = MAP_LINK(objMap, nObjMap, doc->selStartL);
+			doc->selEndL = MAP_LINK(objMap, nObjMap, doc->selEndL);
+			doc->masterHeadL = MAP_LINK(objMap, nObjMap, doc->masterHeadL);
+			doc->masterTailL = MAP_LINK(objMap, nObjMap, doc->masterTailL);
+			doc->oldSelStartL = MAP_LINK(objMap, nObjMap, doc->oldSelStartL);
+			doc->oldSelEndL = MAP_LINK(objMap, nObjMap, doc->oldSelEndL);
+			doc->undo.headL = MAP_LINK(objMap, nObjMap, doc->undo.headL);
+			doc->undo.tailL = MAP_LINK(objMap, nObjMap, doc->undo.tailL);
+			doc->undo.selStartL = MAP_LINK(objMap, nObjMap, doc->undo.selStartL);
+			doc->undo.selEndL = MAP_LINK(objMap, nObjMap, doc->undo.selEndL);
+			doc->undo.scorePrevL = MAP_LINK(objMap, nObjMap, doc->undo.scorePrevL);
+			doc->undo.scoreEndL = MAP_LINK(objMap, nObjMap, doc->undo.scoreEndL);
+			doc->undo.insertL = MAP_LINK(objMap, nObjMap, doc->undo.insertL);
+		}
+		else
+			RemapSubobjLinks(doc, iHp, n, map, objMap, nObjMap);
+	}
+	okay = True;
+
+Done:
+	/* Things that cache LINKs must now rebuild their caches or forget them. */
+	
+	InvalSysPicts(doc);
+	InvalHitIndex();
+	ForgetResultListMatches(doc);
+
+	if (okay) {
+		totBefore = totAfter = 0L;
+		for (iHp = FIRSTtype; iHp<LASTtype; iHp++) {
+			if (nLive[iHp]==0L) continue;
+			FillMem(0, map, (maxObjs+1)*sizeof(LINK));
+			n = HeapListOrder(doc, iHp, order, map);
+			nAfter[iHp] = (n<0L? -1L : HeapScatter(order, n));
+			totBefore += nBefore[iHp];
+			totAfter += nAfter[iHp];
+			if (showDetail)
+				LogPrintf(LOG_INFO, "  heap %d (%s): %ld in use, %ld out of order before, %ld after\n",
+							iHp, NameHeapType(iHp, False), nLive[iHp], nBefore[iHp], nAfter[iHp]);
+		}
+		LogPrintf(LOG_INFO, "Compacted heaps: %ld records out of order before, %ld after.  (CompactHeaps)\n",
+					totBefore, totAfter);
+	}
+
+	if (order) DisposePtr((Ptr)order);
+	if (map) DisposePtr((Ptr)map);
+	if (objMap) DisposePtr((Ptr)objMap);
+	return okay;
+}
+
+
+/* ======================================================== String pool compaction == */
+/* A Document's string pool only grows: PReplace never changes a string in place, since
+it may be shared, and deleting Graphics and Tempos leaves their strings behind. Text that
+was stored before interning, e.g., read from an old file, may also be duplicated many
+times over. CompactStringPool copies every string that's still referenced into a new
+pool, interning them so each distinct string is stored only once, and rewrites the
+references. The references are the STRINGOFFSETs in Graphic subobjects and Tempo objects
+in the main, Master Page, and Undo object lists, and the Document's header and footer.
+(Part names aren't in the string pool.) Like CompactHeaps, it should be called only at
+"top level". */
+
+enum { SM_COUNT, SM_COPY, SM_REWRITE };
+
+typedef struct {
+	StringRef		*oldRef;			/* Hash table from old StringRefs... */
+	StringRef		*newRef;			/* ...to new ones */
+	long			nSlots;				/* Table size; a power of 2 */
+	long			nRefs;				/* No. of references found by SM_COUNT pass */
+	StringPoolRef	oldPool, newPool;
+} STRMAP;
+
+static Boolean MapStringRef(STRINGOFFSET *pRef, STRMAP *pMap, short pass);
+static Boolean MapDocStrings(Document *doc, STRMAP *pMap, short pass);
+
+#define STRMAP_HASH(ref, nSlots)	( ((unsigned long)(ref)*2654435761UL >> 8) & ((nSlots)-1) )
+
+/* Handle one string reference for pass <pass> of CompactStringPool: count it, copy its
+string to the new pool, or change it to refer to the copy. Return False if we run out of
+memory. */
+
+static Boolean MapStringRef(STRINGOFFSET *pRef, STRMAP *pMap, short pass)
+{
+	StringRef ref = *pRef, newRef;
+	Str255 str;
+	long i;
+	
+	if (ref<=emptyStringRef) {
+		if (pass==SM_REWRITE) *pRef = emptyStringRef;
+		return True;
+	}
+	if (pass==SM_COUNT) {
+		pMap->nRefs++;
+		return True;
+	}
+
+	for (i = STRMAP_HASH(ref, pMap->nSlots); pMap->oldRef[i]!=emptyStringRef;
+			i = (i+1) & (pMap->nSlots-1))
+		if (pMap->oldRef[i]==ref) break;
+
+	if (pass==SM_REWRITE) {
+		*pRef = (pMap->oldRef[i]==ref? pMap->newRef[i] : emptyStringRef);
+		return True;
+	}
+	
+	if (pMap->oldRef[i]==ref) return True;						/* Already copied */
+	Pstrcpy(str, PCopyInPool(ref, pMap->oldPool));
+	newRef = PInternInPool(str, pMap->newPool);
+	if (IsErrorStringRef(newRef)) return False;
+	pMap->oldRef[i] = ref;
+	pMap->newRef[i] = newRef;
+	return True;
+}
+
+/* Apply MapStringRef to every string reference in <doc>. */
+
+static Boolean MapDocStrings(Document *doc, STRMAP *pMap, short pass)
+{
+	LINK	headL[3], tailL[3], pL, subL;
+	short	i;
+	
+	headL[0] = doc->headL;			tailL[0] = doc->tailL;
+	headL[1] = doc->masterHeadL;	tailL[1] = doc->masterTailL;
+	headL[2] = doc->undo.headL;		tailL[2] = doc->undo.tailL;
+	
+	for (i = 0; i<3; i++) {
+		if (headL[i]==NILINK) continue;
+		for (pL = headL[i]; pL; pL = RightLINK(pL)) {
+			switch (ObjLType(pL)) {
+				case GRAPHICtype:
+					for (subL = FirstSubLINK(pL); subL; subL = NextLink(GRAPHICheap, subL))
+						if (!MapStringRef(&GraphicSTRING(subL), pMap, pass)) return False;
+					break;
+				case TEMPOtype:
+					if (!MapStringRef(&TempoSTRING(pL), pMap, pass)) return False;
+					if (!MapStringRef(&TempoMETROSTR(pL), pMap, pass)) return False;
+					break;
+				default:
+					;
+			}
+			if (pL==tailL[i]) break;
+		}
+	}
+	
+	if (!MapStringRef(&doc->headerStrOffset, pMap, pass)) return False;
+	if (!MapStringRef(&doc->footerStrOffset, pMap, pass)) return False;
+	return True;
+}
+
+/* Compact <doc>'s string pool, as described above; <doc>'s heaps must be installed.
+Return True if all went well. If there's a problem, nothing is changed. */
+
+Boolean CompactStringPool(Document *doc)
+{
+	STRMAP	strMap;
+	long	oldSize, newSize;
+	Boolean	okay = False;
+	
+	if (doc==NULL || doc->stringPool==NULL || doc->masterView || doc->showFormat) return False;
+
+	strMap.oldRef = strMap.newRef = NULL;
+	strMap.oldPool = doc->stringPool;
+	strMap.newPool = NewStringPool();
+	if (!strMap.newPool) goto NoMemory;
+	
+	/* Count the references, allocate a table with room for at least twice that many,
+	   copy the strings, and only then, when nothing can go wrong, change the references. */
+	
+	strMap.nRefs = 0L;
+	(void)MapDocStrings(doc, &strMap, SM_COUNT);
+	for (strMap.nSlots = 16L; strMap.nSlots<2*strMap.nRefs; strMap.nSlots *= 2)
+		;
+	strMap.oldRef = (StringRef *)NewPtr(strMap.nSlots*sizeof(StringRef));
+	strMap.newRef = (StringRef *)NewPtr(strMap.nSlots*sizeof(StringRef));
+	if (!strMap.oldRef || !strMap.newRef) goto NoMemory;
+	FillMem(0, strMap.oldRef, strMap.nSlots*sizeof(StringRef));
+
+	if (!MapDocStrings(doc, &strMap, SM_COPY)) goto NoMemory;
+	(void)MapDocStrings(doc, &strMap, SM_REWRITE);
+	
+	ShrinkStringPool(strMap.newPool);
+	oldSize = GetHandleSize((Handle)strMap.oldPool);
+	newSize = GetHandleSize((Handle)strMap.newPool);
+	if (GetStringPool()==strMap.oldPool) SetStringPool(strMap.newPool);
+	doc->stringPool = strMap.newPool;
+	strMap.newPool = DisposeStringPool(strMap.oldPool);			/* Sets it to NULL */
+	LogPrintf(LOG_INFO, "Compacted string pool: %ld references, %ld bytes before, %ld after.  (CompactStringPool)\n",
+				strMap.nRefs, oldSize, newSize);
+	okay = True;
+	goto Done;
+
+NoMemory:
+	LogPrintf(LOG_WARNING, "Not enough memory to compact the string pool.  (CompactStringPool)\n");
+	
+Done:
+	if (strMap.newPool) DisposeStringPool(strMap.newPool);
+	if (strMap.oldRef) DisposePtr((Ptr)strMap.oldRef);
+	if (strMap.newRef) DisposePtr((Ptr)strMap.newRef);
+	return okay;
+}
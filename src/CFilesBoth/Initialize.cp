@@ -1556,6 +1556,8 @@ Boolean InitGlobals(void)
 		InsertMenu(appleMenu, 0);
 		
 		fileMenu = GetMenu(fileID);			if (!fileMenu) return False;
+		InsertMenuItem(fileMenu, "\pExport Page Images...", FM_SavePostScript);
+		InsertMenuItem(fileMenu, "\pExport PDF...", FM_SavePostScript);
 		InsertMenu(fileMenu, 0);
 		
 		editMenu = GetMenu(editID);			if (!editMenu) return False;
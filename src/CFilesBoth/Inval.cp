@@ -9,7 +9,8 @@
 		InvalMeasure			InvalMeasures			InvalSystem
 		InvalSystems			InvalSysRange			InvalSelRange
 		InvalRange				EraseAndInvalRange		InvalRangeContent
-		InvalObject
+		InvalObject				BeginInvalBatch			EndInvalBatch
+		FlushInvalBatch			GetInvalBatchStats
 /******************************************************************************************/
 
 /*
@@ -23,6 +24,26 @@
 #include "Nightingale_Prefix.pch"
 #include "Nightingale.appl.h"
 
+static void InvalRangeSysPicts(LINK fromL, LINK toL);
+static void PortEraseAndInval(Rect *r);
+static void WindowInval(WindowPtr w, Rect *r, Boolean erase);
+
+/* While a batch is open, our Inval routines still erase rectangles as they go, so what
+the user sees is the same as without batching, but they don't inval them: they add them to
+one region for the window, and the batch's end invals that region in a single call. DoEvent
+opens a batch around each mouse and keyboard event, so a command like Transpose on a large
+selection, which invals the same Systems over and over, costs the Window Manager one
+invalidation. */
+
+static short invalBatchLevel = 0;
+static WindowPtr dirtyWindow = NULL;		/* Window the region below belongs to */
+static RgnHandle dirtyInvalRgn = NULL;		/* Everything to inval */
+static RgnHandle dirtyTempRgn = NULL;
+
+static long nInvalRects = 0L;				/* Statistics since launch: rects requested, */
+static long nInvalRedundant = 0L;			/*   rects already completely covered, */
+static long nInvalFlushes = 0L;				/*   actual Window Manager Inval calls */
+
 
 /* -----------------------------------------------------------------------InvalMeasure -- */
 /*	Erase and Inval the entire System the specified object is in. Assumes the object
@@ -92,6 +113,7 @@ void InvalSystem(LINK pL)
 
 	systemL = LSSearch(pL, SYSTEMtype, ANYONE, True, False);
 	if (systemL!=NILINK) {
+		InvalSysPict(systemL);
 		r = LinkOBJRECT(systemL);
 		r.left = 0;
 		r.right = doc->paperRect.right;
@@ -99,7 +121,7 @@ void InvalSystem(LINK pL)
 		pageL = LSSearch(pL, PAGEtype, ANYONE, GO_LEFT, False);
 		ContextPage(doc, pageL, contextA);
 		OffsetRect(&r, doc->currentPaper.left, doc->currentPaper.top);
-		EraseAndInval(&r);
+		PortEraseAndInval(&r);
 	}
 
 	doc->currentSheet = oldSheet;
@@ -161,6 +183,8 @@ void InvalRange(LINK fromL, LINK toL)
 	PASLUR	aSlur;
 	Rect	emptyRect;
 
+	InvalHitIndex();
+	InvalRangeSysPicts(fromL, toL);
 	SetRect(&emptyRect, 0, 0, 0, 0);
 	for (pL=fromL; pL && pL!=toL; pL=RightLINK(pL)) {
 		LinkVALID(pL) = False;
@@ -189,11 +213,13 @@ void EraseAndInvalRange(Document *doc, LINK fromL, LINK toL)
 	LINK	pL;
 	Rect	r, emptyRect;
 
+	InvalHitIndex();
+	InvalRangeSysPicts(fromL, toL);
 	SetRect(&emptyRect, 0, 0, 0, 0);
 	for (pL=fromL; pL && pL!=toL; pL=RightLINK(pL)) {
 		r = LinkOBJRECT(pL);
 		Rect2Window(doc,&r);
-		EraseAndInval(&r);
+		PortEraseAndInval(&r);
 		LinkVALID(pL) = False;
 		LinkOBJRECT(pL) = emptyRect;
 	}
@@ -212,6 +238,8 @@ void InvalRangeContent(LINK fromL, LINK toL)
 	LINK	pL;
 	Rect	emptyRect;
 
+	InvalHitIndex();
+	InvalRangeSysPicts(fromL, toL);
 	SetRect(&emptyRect, 0, 0, 0, 0);
 	for (pL=fromL; pL && pL!=toL; pL=RightLINK(pL)) {
 		if (!J_STRUCTYPE(pL)) {
@@ -238,6 +266,7 @@ void InvalObject(Document *doc, LINK pL, short doErase)
 	Rect r, slurBBox;  LINK aSlurL;
 	short inset;
 
+	InvalRangeSysPicts(pL, RightLINK(pL));
 	GetAllContexts(doc,contextA,pL);
 	switch (ObjLType(pL)) {
 		case GRAPHICtype:
@@ -259,7 +288,7 @@ LogPrintf(LOG_DEBUG, "InvalObject: pL=%u strlen=%d\n", pL, Pstrlen(string));
 			aSlurL = FirstSubLINK(pL);
 			for ( ; aSlurL; aSlurL=NextSLURL(aSlurL)) {
 				GetSlurBBox(doc, pL, aSlurL, &slurBBox, 4);
-				InvalWindowRect(doc->theWindow,&slurBBox);
+				WindowInval(doc->theWindow, &slurBBox, False);
 			}
 			break;
 	}
@@ -278,6 +307,126 @@ LogPrintf(LOG_DEBUG, "InvalObject: r=%d,%d,%d,%d doErase=%d\n", r.top, r.left, r
 
 	OffsetRect(&r, doc->currentPaper.left, doc->currentPaper.top);
 
-	if (doErase)	EraseAndInval(&r);
-	else			InvalWindowRect(doc->theWindow,&r);
+	if (doErase)	PortEraseAndInval(&r);
+	else			WindowInval(doc->theWindow, &r, False);
+}
+
+
+/* ---------------------------------------------------------------- InvalRangeSysPicts -- */
+/* Discard the pictures DrawScoreRange keeps of the Systems containing anything in the
+range [fromL, toL), so changes there can't be hidden by replaying an old picture. Pictures
+of other Systems stay usable. */
+
+static void InvalRangeSysPicts(LINK fromL, LINK toL)
+{
+	LINK pL;
+	
+	pL = LSSearch(fromL, SYSTEMtype, ANYONE, GO_LEFT, False);
+	if (pL==NILINK) pL = fromL;
+	for ( ; pL && pL!=toL; pL=RightLINK(pL))
+		if (SystemTYPE(pL)) InvalSysPict(pL);
+}
+
+
+/* -------------------------------------------------------------------- Inval batching -- */
+
+/* Erase and Inval a rectangle in the current port, as EraseAndInval does, or add it to
+the open batch. */
+
+static void PortEraseAndInval(Rect *r)
+{
+	GrafPtr port;
+	
+	GetPort(&port);
+	WindowInval(GetWindowFromPort(port), r, True);
+}
+
+/* Inval a rectangle in the given window now or, if a batch is open, add it to the
+batch's region; if <erase>, erase it immediately in either case, so <w> must be the current
+port's window. A rectangle already covered by the region isn't added again, and is counted
+as redundant. */
+
+static void WindowInval(WindowPtr w, Rect *r, Boolean erase)
+{
+	Document *doc;
+	
+	nInvalRects++;
+	if (w!=NULL && (doc = GetDocumentFromWindow(w))!=NULL)
+		InvalSysPictsInRect(doc, r);					/* Systems it touches may change */
+	if (invalBatchLevel<=0 || dirtyInvalRgn==NULL || w==NULL) {
+		nInvalFlushes++;
+		if (erase)	EraseAndInval(r);
+		else		InvalWindowRect(w, r);
+		return;
+	}
+	
+	if (erase) EraseRect(r);
+	if (w!=dirtyWindow) {
+		FlushInvalBatch();
+		dirtyWindow = w;
+	}
+
+	RectRgn(dirtyTempRgn, r);
+	DiffRgn(dirtyTempRgn, dirtyInvalRgn, dirtyTempRgn);
+	if (EmptyRgn(dirtyTempRgn)) {
+		nInvalRedundant++;
+		return;
+	}
+
+	UnionRgn(dirtyInvalRgn, dirtyTempRgn, dirtyInvalRgn);
+}
+
+/* Open a batch of Invals; batches nest. If we can't get the regions we need, Invals
+just happen immediately, as they would without a batch. */
+
+void BeginInvalBatch()
+{
+	if (dirtyInvalRgn==NULL) {
+		dirtyInvalRgn = NewRgn();
+		dirtyTempRgn = NewRgn();
+		if (dirtyInvalRgn==NULL || dirtyTempRgn==NULL) {
+			if (dirtyInvalRgn) DisposeRgn(dirtyInvalRgn);
+			if (dirtyTempRgn) DisposeRgn(dirtyTempRgn);
+			dirtyInvalRgn = dirtyTempRgn = NULL;
+		}
+	}
+	invalBatchLevel++;
+}
+
+/* Close a batch of Invals; when the outermost one closes, inval everything it
+collected. */
+
+void EndInvalBatch()
+{
+	if (invalBatchLevel<=0) return;
+	
+	invalBatchLevel--;
+	if (invalBatchLevel==0) FlushInvalBatch();
+}
+
+/* Inval everything collected so far, leaving any batch open. This must be done before
+anything that changes the window's coordinate system (e.g., scrolling) or draws the
+window directly instead of waiting for an update event. */
+
+void FlushInvalBatch()
+{
+	if (dirtyWindow==NULL || dirtyInvalRgn==NULL) return;
+	
+	if (!EmptyRgn(dirtyInvalRgn)) {
+		InvalWindowRgn(dirtyWindow, dirtyInvalRgn);
+		nInvalFlushes++;
+	}
+
+	SetEmptyRgn(dirtyInvalRgn);
+	dirtyWindow = NULL;
+}
+
+/* Deliver statistics on Inval batching since launch. Rects requested minus flushes is
+the number of Window Manager calls batching has saved. */
+
+void GetInvalBatchStats(long *pnRects, long *pnRedundant, long *pnFlushes)
+{
+	*pnRects = nInvalRects;
+	*pnRedundant = nInvalRedundant;
+	*pnFlushes = nInvalFlushes;
 }
@@ -671,17 +671,17 @@ static void ListNotesToPlay(Document *doc, LINK fromL, LINK toL, Boolean selecte
 {
 	LINK pL, aNoteL;
 	short iVoice;
-	long playDur;
 	
+	if (!LOG_LEVEL_ON(LOG_DEBUG)) return;					/* Nothing would be logged anyway */
+
 	for (pL = fromL; pL!=toL; pL = RightLINK(pL)) {
 		if (SyncTYPE(pL) && AnyNoteToPlay(doc, pL, selectedOnly)) {
 			aNoteL = FirstSubLINK(pL);
 			for ( ; aNoteL; aNoteL = NextNOTEL(aNoteL)) {
 				if (NoteToBePlayed(doc, aNoteL, selectedOnly)) {
 					iVoice = NoteVOICE(aNoteL);
-					playDur = TiedDur(doc, pL, aNoteL, selectedOnly);
-					LogPrintf(LOG_DEBUG, "Note to play: pL=%u voice=%d noteNum=%d playDur=%ld  (ListNotesToPlay)\n",
-								pL, iVoice, NoteNUM(aNoteL), playDur);
+					LOGPRINTF(LOG_DEBUG, "Note to play: pL=%u voice=%d noteNum=%d playDur=%ld  (ListNotesToPlay)\n",
+								pL, iVoice, NoteNUM(aNoteL), TiedDur(doc, pL, aNoteL, selectedOnly));
 				}
 			}
 		}
@@ -755,6 +755,7 @@ void PlaySequence(
 	OSErr		err = noErr;
 	
 	WaitCursor();
+	PROF_BEGIN(profSetup, "PlaySequence setup");
 
 	/* Get initial system Rect, set all note play times, get part attributes, etc. */
 
@@ -870,6 +871,7 @@ void PlaySequence(
 			default:
 				;
 		}
+	PROF_END(profSetup);
 	
 	/* Make final preparations and enter the main loop to play everything. */
 	
@@ -121,8 +121,11 @@ Boolean DoMenu(long menuChoice)
 		short choice, menu;
 		Boolean keepGoing = True;
 		
+		PROF_SCOPE_ARG("DoMenu", menuChoice);
+		
 		menu = HiWord(menuChoice); choice = LoWord(menuChoice);
 		if (TopDocument) MEHideCaret(GetDocumentFromWindow(TopDocument));
+		SetHeapStatsCommand(menuChoice);
 
 		switch (menu) {
 			case appleID:
@@ -429,6 +432,12 @@ Boolean DoFileMenu(short choice)
 			case FM_SavePostScript:
 				if (doc) DoPostScript(doc);
 				break;
+			case FM_ExportPDF:
+				if (doc) DoExportPDF(doc);
+				break;
+			case FM_ExportPageImages:
+				if (doc) DoExportPageImages(doc);
+				break;
 			case FM_SaveText:
 				if (doc) SaveNotelist(doc, ANYONE, True);
 				break;
@@ -658,7 +667,16 @@ static void DoTestMenu(short choice)
 				}
 				break;
 			case TS_HeapBrowser:
-				HeapBrowser(SYNCtype);
+				if (OptionKeyDown() && ShiftKeyDown())
+					LogHeapStats(doc, True);
+				else if (ShiftKeyDown())
+					LogHeapStats(doc, False);
+				else if (doc && OptionKeyDown()) {
+					CompactHeaps(doc, True);
+					CompactStringPool(doc);
+				}
+				else
+					HeapBrowser(SYNCtype);
 				break;
 			case TS_Context:
 				if (doc) ShowContext(doc);
@@ -676,7 +694,14 @@ static void DoTestMenu(short choice)
 				LogPrintf(LOG_INFO, "ClickMode set to ClickFrame\n");
 				break;
 			case TS_Debug:
-				DoDebug("Menu");
+				if (OptionKeyDown() && ShiftKeyDown())
+					ProfReset();
+				else if (OptionKeyDown()) {
+					ProfLogSummary();
+					(void)ProfWriteTrace(PROF_TRACE_FILE);
+				}
+				else
+					DoDebug("Menu");
 				break;
 			case TS_ShowDebug:
 //				static Boolean showDbgWin = False;
@@ -2403,6 +2428,10 @@ static void FixFileMenu(Document *doc, short nSel)
 		XableItem(fileMenu,FM_GetScan,False);
 		XableItem(fileMenu,FM_SavePostScript,doc!=NULL && doc!=clipboard
 										&& !doc->masterView && !doc->showFormat);
+		XableItem(fileMenu,FM_ExportPDF,doc!=NULL && doc!=clipboard
+										&& !doc->masterView && !doc->showFormat);
+		XableItem(fileMenu,FM_ExportPageImages,doc!=NULL && doc!=clipboard
+										&& !doc->masterView && !doc->showFormat);
 		XableItem(fileMenu,FM_SaveText,doc!=NULL && doc!=clipboard
 										&& !doc->masterView && !doc->showFormat && nSel>0);
 		XableItem(fileMenu,FM_Revert,doc!=NULL && doc->changed && !doc->readOnly &&
@@ -33,6 +33,7 @@
 #include "Nightingale.appl.h"
 
 static void MusCharRect(Rect [], unsigned char, long, Rect *);
+static Boolean FillCharRectCache(Document *, short, short, CharRectCache *);
 
 
 /* ---------------------------------------------------------------- PrintMusFontTables -- */
@@ -277,25 +278,30 @@ static void MusCharRect(Rect bbox[], unsigned char ch, long scale, Rect *r)
 /* ---------------------------------------------------------------- BuildCharRectCache -- */
 /*	If the given document's window's current font is the music font, builds a table of
 CharRects for all characters in the current size, using metric information in the
-cBBox array. If the window's current font is not the music font, does nothing. */
+cBBox array. If the window's current font is not the music font, does nothing.
+
+Tables for the most recently used combinations of music font and size (the window's text
+size, so it reflects magnification as well as staff size) are kept in rectCacheTbl[];
+switching to one of them just copies it into charRectCache. With several documents open
+at different magnifications or staff sizes, this keeps the cache from thrashing. */
 
 #define REFERENCE_CODE MCH_trebleclef		/* Code for reference symbol */
 #define REFERENCE_SIZE 36.0					/* Point size of reference symbol */
 #define REFERENCE_HEIGHT 61.0				/* Height of reference symbol in ref. size */
-	
-void BuildCharRectCache(Document *doc)
+
+#define MAX_RECTCACHES 12					/* No. of font/size combinations to keep */
+
+static CharRectCache rectCacheTbl[MAX_RECTCACHES];	/* fontSize=0 means unused */
+static long rectCacheStamp[MAX_RECTCACHES];			/* For finding least-recently used */
+static long rectCacheClock = 0L;
+
+static Boolean FillCharRectCache(Document *doc, short fontNum, short fontSize,
+									CharRectCache *pCache)
 {
 	Rect		*bbox;
 	short		ic, refCode;
 	short		actualSize;
 	long		scale;
-	WindowPtr	ourPort=doc->theWindow;
-
-	if (GetWindowTxFont(ourPort)!=doc->musicFontNum) return;
-
-	/* If we've already cached the music font in this size, we don't need to do it again. */
-	
-	if (GetWindowTxSize(ourPort)==charRectCache.fontSize) return;
 
 	refCode = MapMusChar(doc->musFontInfoIndex, REFERENCE_CODE);
 	bbox = musFontInfo[doc->musFontInfoIndex].cBBox;
@@ -303,29 +309,62 @@ void BuildCharRectCache(Document *doc)
 		LogPrintf(LOG_INFO, "fontNum=%d refCode=%d bbox[].bottom=%d .top=%d.  (BuildCharRectCache)\n",
 					doc->musicFontNum, refCode, bbox[refCode].bottom, bbox[refCode].top);
 		MayErrMsg("Can't scale the music font: reference symbol has height zero.  (BuildCharRectCache)\n");
-		return;
+		return False;
 	}
 
-	charRectCache.fontNum = GetWindowTxFont(ourPort);
-	charRectCache.fontSize = GetWindowTxSize(ourPort);
-	actualSize = GetActualFontSize(charRectCache.fontSize);
+	actualSize = GetActualFontSize(fontSize);
 	scale = 100000.*(REFERENCE_HEIGHT*(actualSize/REFERENCE_SIZE)
 			/(bbox[refCode].bottom-bbox[refCode].top));
 	if (scale<200) {
 		LogPrintf(LOG_INFO, " fontNum=%d refCode=%d bbox[].bottom=%d .top=%d actualSize=%d.  (BuildCharRectCache)\n",
 					doc->musicFontNum, refCode, bbox[refCode].bottom, bbox[refCode].top);
 		MayErrMsg("Can't scale the music font: roundoff error 1/%ld.  (BuildCharRectCache)", scale);
-		return;
+		return False;
 	}
 
+	pCache->fontNum = fontNum;
+	pCache->fontSize = fontSize;
 	for (ic = 0; ic<256; ic++) {
-		MusCharRect(bbox, (unsigned char)ic, scale, &charRectCache.charRect[ic]);
+		MusCharRect(bbox, (unsigned char)ic, scale, &pCache->charRect[ic]);
 		
 		if (doc->musicFontNum==sonataFontNum) {
 			if (ic==MCH_wholeNoteHead || ic==MCH_halfNoteHead || ic==MCH_quarterNoteHead)
-				InsetRect(&charRectCache.charRect[ic], 0, -1);
+				InsetRect(&pCache->charRect[ic], 0, -1);
 		}
 	}
+	return True;
+}
+
+void BuildCharRectCache(Document *doc)
+{
+	short		i, fontNum, fontSize, iOldest;
+	WindowPtr	ourPort=doc->theWindow;
+
+	fontNum = GetWindowTxFont(ourPort);
+	if (fontNum!=doc->musicFontNum) return;
+
+	/* If we've already cached the music font in this size, we don't need to do it again. */
+	
+	fontSize = GetWindowTxSize(ourPort);
+	if (fontSize==charRectCache.fontSize && fontNum==charRectCache.fontNum) return;
+
+	iOldest = 0;
+	for (i = 0; i<MAX_RECTCACHES; i++) {
+		if (rectCacheTbl[i].fontSize==fontSize && rectCacheTbl[i].fontNum==fontNum
+		&&  fontSize!=0) break;
+		if (rectCacheStamp[i]<rectCacheStamp[iOldest]) iOldest = i;
+	}
+
+	if (i>=MAX_RECTCACHES) {
+		i = iOldest;
+		if (!FillCharRectCache(doc, fontNum, fontSize, &rectCacheTbl[i])) {
+			rectCacheTbl[i].fontSize = 0;
+			return;
+		}
+	}
+
+	rectCacheStamp[i] = ++rectCacheClock;
+	charRectCache = rectCacheTbl[i];
 }
 
 
@@ -382,11 +421,24 @@ void GetMusicAscDesc(
 	long			scale;
 	Rect			r, *bbox;
 	
-	refCode = MapMusChar(doc->musFontInfoIndex, REFERENCE_CODE);
+	static short	prevIndex=-1, prevSize=-1;
+	static long		prevScale;
+	
 	bbox = musFontInfo[doc->musFontInfoIndex].cBBox;
 
-	scale = 100000.*(REFERENCE_HEIGHT*(size/REFERENCE_SIZE)
-					/(bbox[refCode].bottom-bbox[refCode].top));
+	/* Callers usually ask about many strings in the same font and size in a row, so
+	   save the scale factor for that combination rather than recomputing it. */
+	   
+	if (doc->musFontInfoIndex==prevIndex && size==prevSize)
+		scale = prevScale;
+	else {
+		refCode = MapMusChar(doc->musFontInfoIndex, REFERENCE_CODE);
+		scale = 100000.*(REFERENCE_HEIGHT*(size/REFERENCE_SIZE)
+						/(bbox[refCode].bottom-bbox[refCode].top));
+		prevIndex = doc->musFontInfoIndex;
+		prevSize = size;
+		prevScale = scale;
+	}
 
 	ascent = descent = 0;
 	n = (unsigned)string[0];
@@ -271,6 +271,7 @@ LINK InsertNode(Document *doc, LINK link, short type, short subCount)
 				doc->headL = obj;
 			}
 		}
+		InvalHitIndex();						/* Object list has changed */
 	}
 
 	return(obj);
@@ -294,6 +295,8 @@ void CutRange(LINK startL, LINK endL)
 	
 	LeftLINK(startL) = NILINK;					/* Get rid of boundary references so */
 	RightLINK(endMoveL) = NILINK;				/*   that cut nodes are well-formed list */
+
+	InvalHitIndex();							/* Object list has changed */
 }
 
 
@@ -320,6 +323,8 @@ void InsNodeInto(LINK node, LINK beforeL)
 	RightLINK(node) = beforeL;
 	RightLINK(LeftLINK(beforeL)) = node;
 	LeftLINK(beforeL) = node;
+
+	InvalHitIndex();							/* Object list has changed */
 }
 
 
@@ -439,6 +444,7 @@ LINK DeleteNode(Document *doc, LINK node)
 			if ((l = LeftLINK(node)))  RightLINK(l) = RightLINK(node);
 			RightLINK(node) = NILINK;
 			HeapFree(doc->Heap+OBJtype,node);
+			InvalHitIndex();					/* Object list has changed */
 		}
 		 else
 			DeleteRange(doc,node,RightLINK(node));
@@ -41,28 +41,38 @@ void SetMeasVisible(LINK, Boolean);
 static short NormalStemUpDown(Document *, LINK, short, PCONTEXT);
 
 /* Given the first item in a note's modNR list, create a duplicate list and return its
-first item. This expands the ModNR heap one item at a time; it would be somewhat better
-to ask for memory for all the ModNRs at once, but even among the notes that have ModNRs
-at all, few will have more than two, so no big deal.  */
+first item, or NILINK if there's a problem (probably out of memory). We get all the
+ModNRs we need from the heap at once: HeapAlloc delivers them already linked together,
+so we just copy the contents of each and restore its link. */
  
 LINK CopyModNRList(Document *srcDoc, Document *dstDoc, LINK firstModNRL)
 {
-	LINK aModNRL, newModNRList, prevModNRL, newModNRL;
+	LINK aModNRL, newModNRList, newModNRL, nextModNRL;
 	PAMODNR pModNR, pNewModNR;
 	HEAP *srcHeap, *dstHeap;
+	unsigned short nModNRs;
 	
-	newModNRList = NILINK;
 	srcHeap = srcDoc->Heap+MODNRtype;
 	dstHeap = dstDoc->Heap+MODNRtype;
-	for (aModNRL=firstModNRL; aModNRL; aModNRL=DNextMODNRL(srcDoc,aModNRL)) {
-		newModNRL = HeapAlloc(dstHeap, 1);
-		if (!newModNRL) MayErrMsg("CopyModNRList: HeapAlloc failed.");
-		if (!newModNRList)	newModNRList = newModNRL;
-		else				DNextMODNRL(dstDoc,prevModNRL) = newModNRL;
+
+	nModNRs = 0;
+	for (aModNRL=firstModNRL; aModNRL; aModNRL=DNextMODNRL(srcDoc,aModNRL))
+		nModNRs++;
+	if (nModNRs==0) return NILINK;
+
+	newModNRList = HeapAlloc(dstHeap, nModNRs);
+	if (!newModNRList) {
+		MayErrMsg("CopyModNRList: HeapAlloc failed.");
+		return NILINK;
+	}
+	
+	for (aModNRL=firstModNRL, newModNRL=newModNRList; aModNRL;
+			aModNRL=DNextMODNRL(srcDoc,aModNRL), newModNRL=nextModNRL) {
+		nextModNRL = DNextMODNRL(dstDoc,newModNRL);
 		pModNR = (PAMODNR)LinkToPtr(srcHeap,aModNRL);
 		pNewModNR = (PAMODNR)LinkToPtr(dstHeap,newModNRL);
 		BlockMove(pModNR, pNewModNR, sizeof(AMODNR));
-		prevModNRL = newModNRL;
+		pNewModNR->next = nextModNRL;
 	}
 	return newModNRList;
 }
@@ -458,7 +468,7 @@ LogPrintf(LOG_DEBUG, "\tsubsNeeded=%d\n", subsNeeded);
 				InstallStrPool(srcDoc);
 				graphicString = PCopy(aGraphic->strOffset);
 				InstallStrPool(dstDoc);
-				stringOff = PStore(graphicString);
+				stringOff = PIntern(graphicString);
 				if (stringOff<0L) return NILINK;
 				newGraphic = DGetPAGRAPHIC(dstDoc,newSubL);
 				newGraphic->strOffset = stringOff;
@@ -490,8 +500,8 @@ PushLock(dstDoc->Heap+OBJtype);
 			tempoString = PCopy(pTempo->strOffset);
 			metroStr = PCopy(pTempo->metroStrOffset);
 			InstallStrPool(dstDoc);
-			newTempo->strOffset = PStore(tempoString);
-			newTempo->metroStrOffset = PStore(metroStr);
+			newTempo->strOffset = PIntern(tempoString);
+			newTempo->metroStrOffset = PIntern(metroStr);
 			if (newTempo->strOffset<0L || newTempo->metroStrOffset<0L) return NILINK;
 			
 			SetStringPool(currentPool);
@@ -43,7 +43,8 @@ To show a rectangle 4 in. wide and 3 in. high at the top-left of the page, make
 
 /* Parameters */
 
-#define PSBUFSIZE	256
+#define PSBUFSIZE	32768L	/* Output buffer size: big enough to make file writes efficient */
+#define PSLINESIZE	160		/* Enough for any line built by PS_Nums or PS_ShowOp */
 
 #define DDFact		pt2d(1)		 /* points-to-DDIST factor */
 
@@ -63,6 +64,10 @@ static void	PS_RestartPageVars(void);
 static Boolean PS_SetMusicFont(Document *doc, short sizePercent);
 static void	PS_FontRunAround(Document *doc, short fontNum, short fontSize, short fontStyle);
 static void	PS_Char(short ch);
+static void	PS_Bytes(const char *p, long len);
+static char	*PS_LongStr(char *q, long n);
+static void	PS_Nums(short nNums, long nums[], const char *op);
+static void	PS_ShowOp(const unsigned char *str, DDIST x, DDIST y, const char *op);
 static char	*PS_PrtLong(unsigned long arg, Boolean negArg, Boolean doSign,
 						Boolean noSign, short base, short width, short *len);
 static void	PS_Recompute(void);
@@ -1044,15 +1049,12 @@ OSErr PS_EndPage()
 }
 
 /*
- *	Send a given C string out to the open file. This could be made more efficient by
- *	doing it a room-left-sized chunk at a time instead of the simpler character at a
- *	time, but I doubt it's important.
+ *	Send a given C string out to the open file.
  */
 
 OSErr PS_String(char *str)
 {
-
-	while (*str) PS_Char(*(unsigned char *)str++);
+	PS_Bytes(str, strlen(str));
 	return(thisError);
 }
 
@@ -1063,10 +1065,7 @@ OSErr PS_String(char *str)
 
 OSErr PS_PString(unsigned char *str)
 {
-	unsigned short len;
-	
-	len = *str++;
-	while (len-- > 0) PS_Char(*str++);
+	PS_Bytes((char *)str+1, *str);
 	return(thisError);
 }
 
@@ -1098,7 +1097,7 @@ OSErr PS_Resource(short resFile, ResType type, short id)
 		
 		len = GetHandleSize(rsrc);
 		p = *rsrc;
-		while (len-- > 0) PS_Char(*(unsigned char *)p++);
+		PS_Bytes(p, len);
 		PS_Flush();
 		
 		/* Get rid of it and restore old resource path */
@@ -1113,9 +1112,12 @@ OSErr PS_Resource(short resFile, ResType type, short id)
 void PS_Handle()
 {
 		Size len = GetHandleSize(theTextHandle);
-		char *p = *theTextHandle;
-		while (len-- > 0) PS_Char(*(unsigned char *)p++);
+		SignedByte hState = HGetState(theTextHandle);
+		
+		HLock(theTextHandle);
+		PS_Bytes(*theTextHandle, len);
 		PS_Flush();
+		HSetState(theTextHandle, hState);
 }
 	
 /* PS_Print is a simpler, shorter version of printf for printing directly to the the
@@ -1143,7 +1145,7 @@ void PS_Print(char *msg, ...)
 		va_list nxtArg;
 		short base, precision, len, width, n, fieldLength;
 		long arg;  unsigned long argu;
-		char *p;
+		char *p, *run;
 		Boolean wideArg, pascalStr, doPrecision, noSign, doSpace;
 		Boolean leftJustify, doSign, negArg, doZero, doAlternate;
 		
@@ -1155,7 +1157,13 @@ void PS_Print(char *msg, ...)
 		   reached, the program will abort."  --DAB */
 
 		while (*msg)
-			if (*msg != '%') PS_Char(*(unsigned char *)msg++);
+			if (*msg != '%') {
+				/* Send everything up to the next conversion or the end all at once */
+				
+				for (run = msg; *msg && *msg!='%'; msg++)
+					;
+				PS_Bytes(run, msg-run);
+				}
 			
 			 else {
 			 	leftJustify = doSign = doSpace = doZero = doAlternate =
@@ -1292,11 +1300,11 @@ void PS_Print(char *msg, ...)
 			 	
 		 		if (width!=0 && width>fieldLength) {
 		 			if (!leftJustify) while (n++ < width) PS_Char(' ');
-		 			while (fieldLength-- > 0) PS_Char(*(unsigned char *)p++);
+		 			PS_Bytes(p, fieldLength);
 		 			if (leftJustify) while (n++ < width) PS_Char(' ');
 		 			}
 		 		 else
-		 			while (fieldLength-- > 0) PS_Char(*(unsigned char *)p++);
+		 			PS_Bytes(p, fieldLength);
 		 			
 				doEscapes = False;
 			 	msg++;
@@ -1334,7 +1342,10 @@ void PS_SetWidths(DDIST staff, DDIST ledger, DDIST stem, DDIST bar)
 
 OSErr PS_SetLineWidth(DDIST width)
 {
-	PS_Print("%ld setlinewidth\r",(long)width);
+	long nums[1];
+	
+	nums[0] = width;
+	PS_Nums(1, nums, "setlinewidth");
 	return(thisError);
 }
 
@@ -1350,16 +1361,20 @@ OSErr PS_SetLineWidth(DDIST width)
  
 OSErr PS_Line(DDIST x0, DDIST y0, DDIST x1, DDIST y1, DDIST width)
 {
-	PS_Print("%ld %ld %ld %ld %ld ML\r",
-							(long)x1,(long)y1,(long)x0,(long)y0,(long)width);
+	long nums[5];
+	
+	nums[0] = x1; nums[1] = y1; nums[2] = x0; nums[3] = y0; nums[4] = width;
+	PS_Nums(5, nums, "ML");
 	return(thisError);
 }
 
 OSErr PS_LineVT(DDIST x0, DDIST y0, DDIST x1, DDIST y1, DDIST width)
 {
+	long nums[5];
+	
 	/* y-coordinates refer to the TOP of the line! */
-	PS_Print("%ld %ld %ld %ld %ld BM\r",(long)x0,(long)y0,(long)x1,(long)y1,
-				(long)width);
+	nums[0] = x0; nums[1] = y0; nums[2] = x1; nums[3] = y1; nums[4] = width;
+	PS_Nums(5, nums, "BM");
 	return(thisError);
 }
 
@@ -1373,9 +1388,11 @@ OSErr PS_LineHT(DDIST x0, DDIST y0, DDIST x1, DDIST y1, DDIST width)
 							 closepath fill} BD
 	*/
 	
+	long nums[5];
+	
 	/* y-coordinates refer to the TOP of the line! */
-	PS_Print("%ld %ld %ld %ld %ld LHT\r",(long)x0,(long)y0,(long)x1,(long)y1,
-				(long)width);
+	nums[0] = x0; nums[1] = y0; nums[2] = x1; nums[3] = y1; nums[4] = width;
+	PS_Nums(5, nums, "LHT");
 	return(thisError);
 }
 
@@ -1392,12 +1409,10 @@ OSErr PS_HDashedLine(DDIST x0, DDIST y, DDIST x1, DDIST width, DDIST dashLen)
 
 	for (xstart = x0; xstart+dashLen<=x1; xstart += dashLen+spaceLen) {
 		xend = xstart+dashLen;
-		PS_Print("%ld %ld %ld %ld %ld ML\r",(long)xend,(long)y,
-					(long)xstart,(long)y,(long)width);
+		PS_Line(xstart, y, xend, y, width);
 	}
 	if (xend<x1)										/* If necessary, extend final dash */
-		PS_Print("%ld %ld %ld %ld %ld ML\r",(long)x1,(long)y,
-					(long)xend,(long)y,(long)width);
+		PS_Line(xend, y, x1, y, width);
 	return(thisError);
 }
 
@@ -1409,13 +1424,11 @@ OSErr PS_VDashedLine(DDIST x, DDIST y0, DDIST y1, DDIST width, DDIST dashLen)
 	
 	for (ystart = y0; ystart+dashLen<=y1; ystart += dashLen+spaceLen) {
 		yend = ystart+dashLen;
-		PS_Print("%ld %ld %ld %ld %ld ML\r",(long)x,(long)yend,
-					(long)x,(long)ystart,(long)width);
+		PS_Line(x, ystart, x, yend, width);
 		}
 
 	if (ystart<y1)										/* Draw short final dash */
-		PS_Print("%ld %ld %ld %ld %ld ML\r",(long)x,(long)y1,
-					(long)x,(long)ystart,(long)width);
+		PS_Line(x, ystart, x, y1, width);
 	return(thisError);
 }
 
@@ -1436,8 +1449,10 @@ OSErr PS_FrameRect(DRect *dr, DDIST width)
 
 OSErr PS_StaffLine(DDIST height, DDIST x0, DDIST x1)
 {
-	PS_Print("%ld %ld %ld %ld SFL\r",(long)x1,(long)height,
-										(long)x0,(long)height);
+	long nums[4];
+	
+	nums[0] = x1; nums[1] = height; nums[2] = x0; nums[3] = height;
+	PS_Nums(4, nums, "SFL");
 	return(thisError);
 }
 
@@ -1609,8 +1624,10 @@ OSErr PS_Repeat(Document *doc, DDIST top, DDIST bot, DDIST botNorm, DDIST x,
 
 OSErr PS_LedgerLine(DDIST height, DDIST x0, DDIST dx)
 	{
-		PS_Print("%ld %ld %ld %ld LL\r",(long)(x0+dx),(long)height,
-											(long)x0,(long)height);
+		long nums[4];
+		
+		nums[0] = x0+dx; nums[1] = height; nums[2] = x0; nums[3] = height;
+		PS_Nums(4, nums, "LL");
 		return(thisError);
 	}
 
@@ -1627,9 +1644,7 @@ OSErr PS_Beam(DDIST x0, DDIST y0, DDIST x1, DDIST y1, DDIST thick,
 	{
 		if (upOrDown0 > 0) x0 -= (wStem + 4);
 		if (upOrDown1 > 0) x1 -= wStem;
-		PS_Print("%ld %ld %ld %ld %ld BM\r",(long)x0,(long)y0,(long)x1,(long)y1,
-					(long)thick);
-		return(thisError);
+		return PS_LineVT(x0, y0, x1, y1, thick);
 	}
 
 
@@ -1838,8 +1853,7 @@ OSErr PS_MusChar(Document *doc, DDIST x, DDIST y, char sym, Boolean visible, sho
 		str[0] = 1; str[1] = sym;
 		
 		PS_SetMusicFont(doc, sizePercent);
-		PS_Print("(%P)%ld %ld ",str,(long)x,(long)y);
-		PS_Print((char*)(visible?"MS\r":"MSI\r"));
+		PS_ShowOp(str, x, y, (visible? "MS" : "MSI"));
 		
 		return(thisError);
 	}
@@ -1868,7 +1882,7 @@ OSErr PS_FontString(Document *doc, DDIST x, DDIST y, const unsigned char *str,
 			 else
 				PS_FontRunAround(doc, doc->musicFontNum, ptSize, 0);
 			PS_Print("SQW\r");
-			PS_Print("(%P)%ld %ld MS\r", str, (long)x, (long)y);
+			PS_ShowOp(str, x, y, "MS");
 			thisFont = F_None;
 			}
 		else {
@@ -1881,7 +1895,7 @@ OSErr PS_FontString(Document *doc, DDIST x, DDIST y, const unsigned char *str,
 			 	GetFNum(font, &fontNum);
 				PS_FontRunAround(doc, fontNum, ptSize, style);
 				}
-			PS_Print("(%P)%ld %ld MS\r", str, (long)x, (long)y);
+			PS_ShowOp(str, x, y, "MS");
 			thisFont = F_Other;
 			if (!fontKnown) unknownFonts += 1;
 			}
@@ -1897,7 +1911,7 @@ OSErr PS_FontString(Document *doc, DDIST x, DDIST y, const unsigned char *str,
 OSErr PS_MusString(Document *doc, DDIST x, DDIST y, unsigned char *str, short sizePercent)
 	{
 		PS_SetMusicFont(doc, sizePercent);
-		PS_Print("(%P)%ld %ld MS\r",str,(long)x,(long)y);
+		PS_ShowOp(str, x, y, "MS");
 		return(thisError);
 	}
 
@@ -2303,6 +2317,113 @@ static void PS_Char(short ch)
 				}
 	}
 
+/*
+ *	Add <len> bytes to the buffer, a buffer-load at a time, flushing as necessary.
+ *	Only when we're sending output to a printer (which needs each line flushed as
+ *	it's completed) or escaping a string do we have to go a character at a time.
+ */
+
+static void PS_Bytes(const char *p, long len)
+	{
+		long room;
+		
+		if (doEscapes || !(usingFile || usingHandle)) {
+			while (len-- > 0) PS_Char(*(unsigned char *)p++);
+			return;
+			}
+		
+		while (len > 0) {
+			if (bp >= bufTop) PS_Flush();
+			room = bufTop - bp;
+			if (room > len) room = len;
+			BlockMoveData(p, bp, room);
+			bp += room; p += room; len -= room;
+			}
+	}
+
+/*
+ *	Write the decimal representation of <n> at <q>, just as PS_Print's "%ld" would,
+ *	and return a pointer to the char. after it.
+ */
+
+static char *PS_LongStr(char *q, long n)
+	{
+		char digits[12], *d;
+		unsigned long u;
+		
+		u = (unsigned long)n;
+		if (n < 0) { *q++ = '-'; u = -u; }
+		d = digits;
+		do { *d++ = '0' + (u % 10); u /= 10; } while (u);
+		while (d > digits) *q++ = *--d;
+		return(q);
+	}
+
+/*
+ *	Fast path for the most common kind of output: a line consisting of <nNums>
+ *	integers (usually DDIST coordinates and widths) and an operator. Produces the
+ *	same output as PS_Print("%ld ... %ld <op>\r", ...) without parsing a format.
+ */
+
+static void PS_Nums(short nNums, long nums[], const char *op)
+	{
+		char line[PSLINESIZE], *q;
+		short i;
+		
+		q = line;
+		for (i = 0; i < nNums; i++) {
+			q = PS_LongStr(q, nums[i]);
+			*q++ = ' ';
+			}
+		while (*op) *q++ = *op++;
+		*q++ = '\r';
+		PS_Bytes(line, q-line);
+	}
+
+/*
+ *	Fast path for showing a Pascal string (usually a single music character) at a
+ *	point: produces the same output as PS_Print("(%P)%ld %ld <op>\r", ...). Strings
+ *	too long to build in our line buffer are passed on to PS_Print.
+ */
+
+static void PS_ShowOp(const unsigned char *str, DDIST x, DDIST y, const char *op)
+	{
+		char line[PSLINESIZE], *q;
+		short i, len;
+		unsigned char ch;
+		
+		len = str[0];
+		if (len > (PSLINESIZE-40)/4) {
+			PS_Print("(%P)%ld %ld ", str, (long)x, (long)y);
+			PS_Print("%s\r", op);
+			return;
+			}
+		
+		q = line;
+		*q++ = '(';
+		for (i = 1; i <= len; i++) {
+			ch = str[i];
+			if ((ch<' ' && (ch!='\r' && ch!='\t')) || (ch > 127)) {
+				*q++ = '\\';							/* Same escapes as PS_Char */
+				*q++ = '0' + ((ch >> 6)&3);
+				*q++ = '0' + ((ch >> 3)&7);
+				*q++ = '0' + (ch & 7);
+				}
+			 else {
+				if (ch=='(' || ch==')' || ch=='\\') *q++ = '\\';
+				*q++ = ch;
+				}
+			}
+		*q++ = ')';
+		q = PS_LongStr(q, (long)x);
+		*q++ = ' ';
+		q = PS_LongStr(q, (long)y);
+		*q++ = ' ';
+		while (*op) *q++ = *op++;
+		*q++ = '\r';
+		PS_Bytes(line, q-line);
+	}
+
 /*
  *	Convert a long integer to a static string and deliver pointer to string.  Gets
  *	digits in reverse order, and then reverses them. This might be better in-line
@@ -78,6 +78,7 @@ void QuickScroll(register Document *doc, register short dx, register short dy,
 		short width, height,cVal,cMax,cMin,nUpdates,i,nScreens;
 		
 		w = doc->theWindow;
+		FlushInvalBatch();							/* Batched Invals are in the old coordinates */
 		GetPort(&oldPort); SetPort(GetWindowPort(w));
 		
 		/*
@@ -307,10 +308,12 @@ void QuickScroll(register Document *doc, register short dx, register short dy,
 			
 			/* Got our list: now update them all in reverse order (palettes first) */
 			
+			UseSysPicts(True);			/* Nothing's changed but what's in view */
 			for (nr=updateRectTable; nr!=nextRect; nr++) {
 				doc->showWaitCurs = False;	/* Avoid distracting cursor changes when auto-scrolling */
 				DrawDocumentView(doc,nr);
 				}
+			UseSysPicts(False);
 		
 			/*
 			 *	If window is on more than one screen, just invalidate everything
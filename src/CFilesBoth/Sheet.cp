@@ -12,6 +12,7 @@
 #include "Nightingale.appl.h"
 
 static Boolean GetVisibleSheet(Document *doc, short *i);
+static Boolean PrerenderSheet(Document *doc, short nSheet);
 
 /* Scroll the sheet world so that a given sheet is visible in upper left.
 ??DOES NOTHING if the sheet is not in the visible array! */
@@ -680,6 +681,92 @@ void DrawSheet(Document *doc, short i, Rect *paper, Rect *vis)
 	}
 
 
+/* Get the sheets before and after the one at the upper left of the window ready to be
+shown instantly: draw them into an offscreen port, so DrawScoreRange records pictures of
+their Systems. Scrolling to one of them then just draws the pictures. Intended to be
+called at idle time; to stay responsive, we render at most one sheet per call, nothing
+if the pictures are already there, and we stop as soon as the user does anything. Since
+editing discards only the pictures of the Systems it touches, little is redone after an
+edit. Playback doesn't get idle time, so its page turns only benefit from sheets that
+were prerendered before it started. */
+
+void PrerenderSheets(Document *doc)
+	{
+		short i;
+		
+		if (outputTo!=toScreen) return;
+		if (!GetVisibleSheet(doc, &i)) return;
+		
+		if (PrerenderSheet(doc, i+1)) return;
+		(void)PrerenderSheet(doc, i-1);
+	}
+
+/* If sheet <nSheet> is not in view and its first System has no picture, draw the sheet
+offscreen to record pictures of its Systems. Return True if we drew it, even if we were
+interrupted. We remember a sheet that we drew completely but still failed to get a
+picture for, so we don't keep drawing it. */
+
+static Boolean PrerenderSheet(Document *doc, short nSheet)
+	{
+		static Document *failDoc=NULL;  static short failSheet, failMagnify;
+		Rect paper, result, oldCurrPaper;
+		LINK pageL, sysL;
+		GWorldPtr gWorld;
+		PixMapHandle pixMapH;
+		CGrafPtr origPort;
+		GDHandle origDev;
+		short status, oldCurrSheet;
+		Boolean finished;
+		
+		if (nSheet<0 || nSheet>=doc->numSheets) return False;
+		if (doc==failDoc && nSheet==failSheet && doc->magnify==failMagnify) return False;
+		
+		status = GetSheetRect(doc, nSheet, &paper);
+		if (status!=INARRAY_INRANGE && status!=INARRAY_OVERFLOW) return False;
+		if (SectRect(&paper, &doc->viewRect, &result)) return False;	/* In view: drawn normally */
+		
+		pageL = LSSearch(doc->headL, PAGEtype, nSheet, GO_RIGHT, False);
+		if (!pageL) return False;
+		sysL = LSSearch(pageL, SYSTEMtype, ANYONE, GO_RIGHT, False);
+		if (!sysL || SysPAGE(sysL)!=pageL) return False;
+		if (SysPictRecorded(doc, sysL, &paper)) return False;
+		
+		/* The offscreen port's coordinates are the sheet's window coordinates, so the
+		   pictures can be replayed directly in the window. Its pixels don't matter, so
+		   1 bit deep is enough. */
+		   
+		if (NewGWorld(&gWorld, 1, &paper, NULL, NULL, 0)!=noErr || gWorld==NULL) return False;
+		pixMapH = GetGWorldPixMap(gWorld);
+		if (!LockPixels(pixMapH)) {
+			DisposeGWorld(gWorld);
+			return False;
+			}
+		
+		oldCurrSheet = doc->currentSheet;
+		oldCurrPaper = doc->currentPaper;
+		GetGWorld(&origPort, &origDev);
+		SetGWorld(gWorld, NULL);
+		EraseRect(&paper);
+		ClipRect(&paper);
+		BeginPrerender();
+		DrawSheet(doc, nSheet, &paper, &paper);
+		finished = EndPrerender();
+		SetGWorld(origPort, origDev);
+		doc->currentSheet = oldCurrSheet;
+		doc->currentPaper = oldCurrPaper;
+		
+		UnlockPixels(pixMapH);
+		DisposeGWorld(gWorld);
+		
+		if (finished && !SysPictRecorded(doc, sysL, &paper)) {
+			failDoc = doc;
+			failSheet = nSheet;
+			failMagnify = doc->magnify;
+			}
+		return True;
+	}
+
+
 /* Invalidate the content of the given range of sheets, forcing an update of
 sheets firstSheet through lastSheet, inclusive. */
 
@@ -840,6 +840,8 @@ DDIST Respace1Bar(
 	DDIST		minWidth, currentxd;
 	LONGSTDIST	position[MAX_MEASNODES];		/* Position table for J_IT & J_IP objs. for the measure */
 
+	PROF_SCOPE("Respace1Bar");
+
 	if (nLast>=MAX_MEASNODES) return 0;
 	
 	/* Allow for the right width of the preceding barline if there is one and it's in the
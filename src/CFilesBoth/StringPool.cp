@@ -80,10 +80,35 @@ static StringPoolRef *poolStack,			/* Stack for pushing/popping pool contexts */
 					 *poolStackPtr;			/* Where to push to and pop from */
 
 
+/* Interning. PInternInPool finds a Pascal string already in a pool with the same
+contents via a hash table from contents to StringRef, so text that's used over and over
+(lyric syllables, chord symbols, repeated text Graphics) is stored only once. The tables
+aren't part of the pools, so they're never saved in files: each pool's table starts out
+empty and remembers only strings interned since. Every hit is checked against the pool's
+actual contents, so a stale entry can cost a duplicate string but never a wrong one. */
+
+#define MAXINTERNPOOLS		8				/* Max. no. of pools with intern tables */
+#define FIRSTINTERNSLOTS	256				/* Initial table size; must be a power of 2 */
+
+typedef struct {
+		StringPoolRef pool;					/* nil = table not in use */
+		StringRef *slot;					/* Open addressing; emptyStringRef = empty slot */
+		long nSlots;
+		long nUsed;
+		} InternTable;
+
+static InternTable internTable[MAXINTERNPOOLS];
+
+
 /* Private routine prototypes */
 
 static OSErr	MoreStringMemory(long n, StringPoolRef pool);
 static void	DefaultNoMemory(OSErr err);
+static InternTable *GetInternTable(StringPoolRef pool, int create);
+static void	ForgetInternTable(StringPoolRef pool);
+static unsigned long HashPString(Byte *str);
+static int	IsPStringAt(StringPool *p, StringRef offset, Byte *str);
+static int	GrowInternTable(InternTable *t, StringPoolRef pool);
 
 
 /* Re-initialize the String Manager to use a push/pop context stack of given nesting size,
@@ -193,7 +218,10 @@ StringPoolRef NewStringPool()
 
 StringPoolRef DisposeStringPool(StringPoolRef pool)
 	{
-		if (pool) DisposeHandle((Handle)pool);
+		if (pool) {
+			ForgetInternTable(pool);
+			DisposeHandle((Handle)pool);
+			}
 
 		return(nil);
 	}
@@ -209,6 +237,8 @@ int InitStringPool(StringPoolRef pool, long size)
 		if (pool) {
 			StringPool *p = *pool;								/* Caution: floating ptr */
 			
+			ForgetInternTable(pool);
+			
 			/* To facilitate debugging, fill the <bottomByte> array with a distinctive value. */
 			for (short i = 0; i<MAXSAVE; i++)
 				p->bottomByte[i] = 0xABCDE;
@@ -284,6 +314,7 @@ void ClearStringsInPool(StringPoolRef pool)
 		
 		if (pool == nilpool) pool = thePool;
 		
+		ForgetInternTable(pool);
 		p = *pool;
 		p->firstFreeByte = p->bottomByte[p->saveLevel];
 	}
@@ -336,6 +367,7 @@ void RestoreStringsInPool(StringPoolRef pool)
 		
 		if (pool == nilpool) pool = thePool;
 		
+		ForgetInternTable(pool);
 		p = *pool;
 		if (p->saveLevel > 0)
 			p->firstFreeByte = p->bottomByte[p->saveLevel--];
@@ -348,6 +380,7 @@ void ClearFromStringInPool(StringRef offset, StringPoolRef pool)
 		StringPool *p;
 		
 		if (pool == nilpool) pool = thePool;
+		ForgetInternTable(pool);
 		p = *pool;
 		
 		if (offset <= 0)
@@ -648,14 +681,15 @@ StringRef PStoreInPool(Byte *str, StringPoolRef pool)
 		return(start);
 	}
 
-/* Replace the string at a given offset with another string and deliver new offset.
-If the replacement is longer than the one already there, add new one, and deliver new
-offset, which may be -1 if error.  Old storage will be lost, except if allocation is
-done at some save level that gets restored. */
+/* Replace the string at a given offset with another string and deliver new offset,
+which may be -1 if error. Since the string at <offset> may have been interned, other
+references may share it, so we never change it in place: we just intern the new value
+and deliver its offset. The old value stays in the pool until it's compacted, or until
+allocation is done at some save level that gets restored. */
 
 StringRef PReplaceInPool(StringRef offset, Byte *str, StringPoolRef pool)
 	{
-		Byte *dst;  long len, newLen;
+		Byte *dst;
 		StringPool *p;
 		
 		/* If the string is nil or empty, always maps to the canonical empty string
@@ -677,29 +711,151 @@ StringRef PReplaceInPool(StringRef offset, Byte *str, StringPoolRef pool)
 		dst = ((Byte *)p) + offset;
 		if (*dst==0 || *dst>(C_String|P_String)) return(badParamStringRef);
 		
-		if ((*dst++ & P_String) == 0) {		/* Moves dst up to length byte */
+		if ((*dst & P_String) == 0) {
 			SysBeep(1);
 			return(badParamStringRef);
 			}
 		
-		/* Check to see if string being replaced is last string in pool */
+		return(PInternInPool(str,pool));
+	}
+
+/* Deliver the offset of a Pascal string in the given pool with the same contents as
+<str>, storing it first if there isn't one we know about. If the pool's intern table
+can't be allocated, this is the same as PStoreInPool. */
+
+StringRef PInternInPool(Byte *str, StringPoolRef pool)
+	{
+		InternTable *t;  StringRef ref;  long i;
 		
-		len = 2 + *dst;
-		if ((offset + len) == p->firstFreeByte) {
-			/* Yup, it's last string in pool */
-			
-			p->firstFreeByte = offset;				/* Delete it */
-			return(PStoreInPool(str,pool));			/* and append */
+		if (str==nil || *str==0) return(emptyStringRef);
+		
+		if (pool == nilpool) pool = thePool;
+		
+		t = GetInternTable(pool, True);
+		if (t == nil) return(PStoreInPool(str,pool));
+		
+		/* Look for it. The table is never allowed to fill, so this always ends. */
+		
+		for (i = HashPString(str) & (t->nSlots-1); (ref = t->slot[i]) != emptyStringRef;
+				i = (i+1) & (t->nSlots-1))
+			if (IsPStringAt(*pool,ref,str)) return(ref);
+		
+		/* Not there: store it, and remember it if there's room. */
+		
+		ref = PStoreInPool(str,pool);
+		if (IsErrorStringRef(ref)) return(ref);
+		
+		if (2*(t->nUsed+1) > t->nSlots) {
+			if (!GrowInternTable(t,pool) && t->nUsed+2 >= t->nSlots) return(ref);
+			for (i = HashPString(str) & (t->nSlots-1); t->slot[i] != emptyStringRef;
+					i = (i+1) & (t->nSlots-1)) ;
 			}
+		t->slot[i] = ref;
+		t->nUsed++;
+		
+		return(ref);
+	}
+
+/* Deliver the intern table for the given pool, or nil if it has none. If it has none
+and <create>, try to create one. */
+
+static InternTable *GetInternTable(StringPoolRef pool, int create)
+	{
+		InternTable *t, *freeT = nil;  short i;
 		
-		newLen = 2 + *str;
-		if (newLen > len)
-			return(PStoreInPool(str,pool));		/* If won't fit, append it to pool  */
+		for (i = 0; i<MAXINTERNPOOLS; i++) {
+			t = &internTable[i];
+			if (t->pool == pool) return(t);
+			if (t->pool==nil && freeT==nil) freeT = t;
+			}
+		if (!create || freeT==nil) return(nil);
 		
-		while (--newLen > 0)
-			*dst++ = *str++;					/* Else, overwrite old value */
+		freeT->slot = (StringRef *)NewPtrClear(FIRSTINTERNSLOTS*sizeof(StringRef));
+		if (freeT->slot == nil) return(nil);
+		freeT->pool = pool;
+		freeT->nSlots = FIRSTINTERNSLOTS;
+		freeT->nUsed = 0;
 		
-		return(offset);
+		return(freeT);
+	}
+
+/* Discard the given pool's intern table, if it has one. Must be called whenever strings
+are removed from the pool or it's disposed of. */
+
+static void ForgetInternTable(StringPoolRef pool)
+	{
+		InternTable *t;
+		
+		if (pool==nil || (t = GetInternTable(pool,False))==nil) return;
+		
+		DisposePtr((Ptr)t->slot);
+		t->slot = nil;
+		t->pool = nil;
+	}
+
+/* FNV-1a hash of a Pascal string, including its length byte. */
+
+static unsigned long HashPString(Byte *str)
+	{
+		unsigned long h = 2166136261UL;  short len = 1 + *str;
+		
+		while (len-- > 0) {
+			h ^= *str++;
+			h *= 16777619UL;
+			}
+		
+		return(h);
+	}
+
+/* Tell caller whether the Pascal string at the given offset in the given pool exists
+and has the same contents as <str>. */
+
+static int IsPStringAt(StringPool *p, StringRef offset, Byte *str)
+	{
+		Byte *start;  short len;
+		
+		if (offset<=emptyStringRef || offset+2+*str > p->firstFreeByte) return(False);
+		
+		start = ((Byte *)p) + offset;
+		if ((*start++ & P_String) == 0) return(False);
+		
+		for (len = 1 + *str; len > 0; len--)
+			if (*start++ != *str++) return(False);
+		
+		return(True);
+	}
+
+/* Double the size of the given intern table, dropping any entries that no longer point
+to Pascal strings. Deliver True if done, False if not enough memory. */
+
+static int GrowInternTable(InternTable *t, StringPoolRef pool)
+	{
+		StringRef *newSlot, ref;  long newNSlots, i, j;
+		StringPool *p;  Byte *str;
+		
+		newNSlots = 2*t->nSlots;
+		newSlot = (StringRef *)NewPtrClear(newNSlots*sizeof(StringRef));
+		if (newSlot == nil) return(False);
+		
+		p = *pool;
+		t->nUsed = 0;
+		for (i = 0; i<t->nSlots; i++) {
+			ref = t->slot[i];
+			if (ref<=emptyStringRef || ref+2 > p->firstFreeByte) continue;
+			str = ((Byte *)p) + ref;
+			if ((*str++ & P_String) == 0 || !IsPStringAt(p,ref,str)) continue;
+			
+			for (j = HashPString(str) & (newNSlots-1); newSlot[j] != emptyStringRef;
+					j = (j+1) & (newNSlots-1)) ;
+			newSlot[j] = ref;
+			t->nUsed++;
+			}
+		
+		DisposePtr((Ptr)t->slot);
+		t->slot = newSlot;
+		t->nSlots = newNSlots;
+		
+		return(True);
 	}
 
 /*
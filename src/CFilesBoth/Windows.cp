@@ -606,6 +606,7 @@ void InvalWindow(Document *doc)
 	GetPort(&oldPort);
 	SetPort(ourPort);
 	MEHideCaret(doc);
+	InvalSysPicts(doc);
 	
 	/* DrawDocument fills in the background and erases each sheet being updated first,
 	   so there's no need to erase first. This reduces flash significantly. */
@@ -12,6 +12,8 @@
 	DisplayObject			MemUsageStats			DisplayIndexNode
 	DHexDump				DSubobjDump				DSubobj5Dump
 	DObjDump				DPrintRow
+	ProfBegin				ProfEnd					ProfReset
+	ProfLogSummary			ProfWriteTrace
 */
 
 #include "Nightingale_Prefix.pch"
@@ -811,3 +813,169 @@ void DPrintRow(Byte bitmap[], short startLoc, short byWidth, short rowNum,
 		printf(" ");		
 	}
 }
+
+
+/* ------------------------------------------------------------------- Profiling hooks -- */
+/* Support for the PROF_* macros in Debug.h. Each timed stretch of code is an event in a
+ring buffer. When the buffer fills, the oldest events are overwritten, so reports always
+cover the most recent PROF_RING_SIZE events. Times are in microseconds since startup.
+If PROFILE_HOOKS isn't #defined, nothing calls ProfBegin or ProfEnd, and the reporting
+functions just say there's nothing to report. */
+
+#define PROF_RING_SIZE	8192
+#define MAX_PROF_NAMES	64
+
+#ifdef PROFILE_HOOKS
+
+typedef struct {
+	const char	*name;
+	long		arg;
+	long		seq;					/* Serial no. of the event, to detect overwriting */
+	UInt64		start;
+	long		dur;					/* -1 = hasn't ended (yet) */
+} PROFEVENT;
+
+static PROFEVENT profRing[PROF_RING_SIZE];
+static long profNextSeq = 0L;			/* Serial no. of the next event */
+static long profFirstSeq = 0L;			/* Serial no. of the first event since ProfReset */
+
+static UInt64 ProfNow(void);
+static long ProfOldestSeq(void);
+
+static UInt64 ProfNow()
+{
+	UnsignedWide us;
+	
+	Microseconds(&us);
+	return (((UInt64)us.hi)<<32) | us.lo;
+}
+
+static long ProfOldestSeq()
+{
+	long oldestSeq = profNextSeq-PROF_RING_SIZE;
+	
+	return (oldestSeq>profFirstSeq? oldestSeq : profFirstSeq);
+}
+
+#endif
+
+/* Start timing an event and return its serial no., to be passed to ProfEnd. <name> must
+be a string constant or otherwise persist indefinitely. */
+
+long ProfBegin(const char *name, long arg)
+{
+#ifdef PROFILE_HOOKS
+	long seq = profNextSeq++;
+	PROFEVENT *pEvent = &profRing[seq % PROF_RING_SIZE];
+
+	pEvent->name = name;
+	pEvent->arg = arg;
+	pEvent->seq = seq;
+	pEvent->dur = -1L;
+	pEvent->start = ProfNow();
+	return seq;
+#else
+	return -1L;
+#endif
+}
+
+void ProfEnd(long event)
+{
+#ifdef PROFILE_HOOKS
+	PROFEVENT *pEvent;
+	
+	if (event<0L) return;
+	pEvent = &profRing[event % PROF_RING_SIZE];
+	if (pEvent->seq!=event) return;					/* Already overwritten */
+	pEvent->dur = (long)(ProfNow()-pEvent->start);
+#endif
+}
+
+/* Forget all events so far. Events still in progress are never reported. */
+
+void ProfReset()
+{
+#ifdef PROFILE_HOOKS
+	profFirstSeq = profNextSeq;
+	LogPrintf(LOG_INFO, "Profiling events cleared.  (ProfReset)\n");
+#endif
+}
+
+/* Log the number of times each event was recorded, and its total and maximum times. */
+
+void ProfLogSummary()
+{
+#ifdef PROFILE_HOOKS
+	const char *name[MAX_PROF_NAMES];
+	long count[MAX_PROF_NAMES], maxDur[MAX_PROF_NAMES];
+	UInt64 totalDur[MAX_PROF_NAMES];
+	short nNames = 0, n;
+	long seq;
+	PROFEVENT *pEvent;
+	
+	for (seq = ProfOldestSeq(); seq<profNextSeq; seq++) {
+		pEvent = &profRing[seq % PROF_RING_SIZE];
+		if (pEvent->seq!=seq || pEvent->dur<0L) continue;
+		for (n = 0; n<nNames; n++)
+			if (name[n]==pEvent->name) break;
+		if (n==nNames) {
+			if (nNames>=MAX_PROF_NAMES) continue;
+			name[n] = pEvent->name;
+			count[n] = maxDur[n] = 0L;
+			totalDur[n] = 0;
+			nNames++;
+		}
+		count[n]++;
+		totalDur[n] += pEvent->dur;
+		if (pEvent->dur>maxDur[n]) maxDur[n] = pEvent->dur;
+	}
+
+	LogPrintf(LOG_INFO, "Profile of the last %ld events (times in microsec.):  (ProfLogSummary)\n",
+				profNextSeq-ProfOldestSeq());
+	for (n = 0; n<nNames; n++)
+		LogPrintf(LOG_INFO, "  %-24s count=%ld total=%llu avg=%llu max=%ld\n", name[n],
+					count[n], totalDur[n], totalDur[n]/count[n], maxDur[n]);
+#else
+	LogPrintf(LOG_INFO, "Profiling hooks aren't compiled in.  (ProfLogSummary)\n");
+#endif
+}
+
+/* Write the events in the ring buffer to the given file in Chrome trace-event format,
+which chrome://tracing and many other trace viewers can display as a timeline. Return
+True if all went well. */
+
+Boolean ProfWriteTrace(char *pathName)
+{
+#ifdef PROFILE_HOOKS
+	FILE *f;
+	long seq, nWritten = 0L;
+	PROFEVENT *pEvent;
+	
+	f = fopen(pathName, "w");
+	if (!f) {
+		LogPrintf(LOG_ERR, "Couldn't open file '%s'.  (ProfWriteTrace)\n", pathName);
+		return False;
+	}
+
+	fprintf(f, "{\"traceEvents\":[");
+	for (seq = ProfOldestSeq(); seq<profNextSeq; seq++) {
+		pEvent = &profRing[seq % PROF_RING_SIZE];
+		if (pEvent->seq!=seq || pEvent->dur<0L) continue;
+		fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%ld,\"pid\":1,\"tid\":1,"
+					"\"args\":{\"arg\":%ld}}", (nWritten>0L? "," : ""), pEvent->name,
+					pEvent->start, pEvent->dur, pEvent->arg);
+		nWritten++;
+	}
+	fprintf(f, "\n]}\n");
+
+	if (fclose(f)!=0) {
+		LogPrintf(LOG_ERR, "Error writing file '%s'.  (ProfWriteTrace)\n", pathName);
+		return False;
+	}
+	LogPrintf(LOG_INFO, "Wrote %ld events to '%s'.  (ProfWriteTrace)\n", nWritten, pathName);
+	return True;
+#else
+	LogPrintf(LOG_INFO, "Profiling hooks aren't compiled in.  (ProfWriteTrace)\n");
+	return False;
+#endif
+}
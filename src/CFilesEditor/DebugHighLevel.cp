@@ -7,8 +7,8 @@
  */
 
 /* DebugHighLevel.c - Debug command and high-level functions:
-	DCheckEverything			DebugDialog				ResetDErrLimit
-	DErrLimit					DoDebug
+	DCheckEverything			DCheckEverythingResults	DebugDialog
+	ResetDErrLimit				DErrLimit				DoDebug
  */
 
 #include "Nightingale_Prefix.pch"
@@ -22,6 +22,7 @@ static short DebugDialog(char *, short *, short *, short *, Boolean *, Boolean *
 
 short nerr, errLim;
 Boolean minDebugCheck;			/* Do only Most important checks? */
+Boolean dcheckHeadless;			/* Checking with no user interface? */
 
 
 /* ------------------------------------------------------------------ DCheckEverything -- */
@@ -34,18 +35,83 @@ There are four levels of checks:
 	Most important: messages about problems are prefixed with '•'
 	More important: messages about problems are prefixed with '*'
 	Less & Least important: messages about problems have no prefix
-*/
+
+DCheckEverything is for interactive use: the user can interrupt it, and it asks before
+going on after many errors. DCheckEverythingResults does the same checks with no user
+interface at all, and describes what it found in a DCHECKRESULTS. Both call DCheckAll to
+do the work. */
+
+#define DCHECK_INTERRUPT_INTVL 64	/* No. of objects to check between looks for interrupt */
+
+static Boolean DCheckAll(Document *, Boolean, Boolean, DCHECKRESULTS *);
+static void DNotePass(DCHECKRESULTS *, const char *, short);
+static Boolean DStopChecking(Boolean);
 
 Boolean DCheckEverything(Document *doc,
 			Boolean maxCheck,	/* True=do even Least important checks */
 			Boolean minCheck	/* True=print only results of More & Most important checks */
 			)
+{
+	DCHECKRESULTS results;
+
+	minDebugCheck = minCheck;
+	return DCheckAll(doc, maxCheck, False, &results);
+}
+
+
+/* Do all the checks DCheckEverything does, including the Less & Least important ones if
+<maxCheck>, without interaction of any kind: there's no limit on the no. of errors, no
+beeping, and no looking for user interrupts. Messages describing problems go to the log
+as usual; in addition, fill in *pResults with the no. of problems each check found, in
+the order they were done, so the caller (e.g., a batch job validating many scores) can
+decide what to do about them. Return True if things are so badly damaged that checking
+couldn't be completed. */
+
+Boolean DCheckEverythingResults(Document *doc, Boolean maxCheck, DCHECKRESULTS *pResults)
+{
+	Boolean fatal, oldMinCheck;
+	
+	oldMinCheck = minDebugCheck;
+	minDebugCheck = False;
+	dcheckHeadless = True;
+	fatal = DCheckAll(doc, maxCheck, True, pResults);
+	dcheckHeadless = False;
+	minDebugCheck = oldMinCheck;
+	
+	return fatal;
+}
+
+
+/* Record in *pResults that check <name> is done and reported all problems after the
+first <nerrBefore>. */
+
+static void DNotePass(DCHECKRESULTS *pResults, const char *name, short nerrBefore)
+{
+	pResults->nErrors = nerr;
+	if (pResults->nPasses>=MAX_DCHECK_PASSES) return;
+	
+	pResults->pass[pResults->nPasses].name = name;
+	pResults->pass[pResults->nPasses].nErrors = nerr-nerrBefore;
+	pResults->nPasses++;
+}
+
+
+static Boolean DStopChecking(Boolean headless)
+{
+	if (headless) return False;
+	return (DErrLimit() || UserInterrupt());
+}
+
+
+static Boolean DCheckAll(Document *doc, Boolean maxCheck, Boolean headless,
+							DCHECKRESULTS *pResults)
 {
 	LINK	pL;
-	short	nInRange, nSel, nTotal, nvUsed;
+	short	nInRange, nSel, nTotal, nvUsed, nerrBefore;
 	Boolean	strictCont, looseCont;
 
-	minDebugCheck = minCheck;
+	pResults->fatal = True;
+	pResults->nObjs = pResults->nErrors = pResults->nPasses = 0;
 	 
 #ifdef DDB
 	LogPrintf(LOG_INFO, "--CHECK MAIN:\n");
@@ -59,7 +125,8 @@ Boolean DCheckEverything(Document *doc,
 
 	/* First check individually all nodes in the object list; this includes their links,
 	   since the "global" checks must assume they can successfully traverse the data
-	   structure. */
+	   structure. Looking for a user interrupt takes much longer than checking a node,
+	   so do it only every DCHECK_INTERRUPT_INTVL nodes. */
 	   
 	ResetDErrLimit();
 	nTotal = 0;
@@ -72,44 +139,72 @@ Boolean DCheckEverything(Document *doc,
 	for (pL = doc->headL; pL!=doc->tailL; pL = RightLINK(pL)) {
 		nTotal++;
 		if (DCheckNode(doc, pL, MAIN_DSTR, maxCheck)<0) return True;
-		if (UserInterrupt()) return False;
 
-		DCheckNodeSel(doc, pL);		if (DErrLimit() || UserInterrupt()) return False;
+		DCheckNodeSel(doc, pL);
+		if (!headless) {
+			if (DErrLimit()) goto Stopped;
+			if (nTotal%DCHECK_INTERRUPT_INTVL==0 && UserInterrupt()) goto Stopped;
+		}
 	}
 	nTotal++;														/* Count tailL */
 	
 	if (DCheckNode(doc, doc->tailL, MAIN_DSTR, maxCheck)<0) return True;
 	
-	DCheckNodeSel(doc, doc->tailL); if (DErrLimit() || UserInterrupt()) return False;
+	DCheckNodeSel(doc, doc->tailL);
+	pResults->nObjs = nTotal;
+	DNotePass(pResults, "DCheckNode", 0);
+	if (DStopChecking(headless)) goto Stopped;
 
+	nvUsed = 0;
 	if (doc!=clipboard) {
-		DCheckVoiceTable(doc, maxCheck, &nvUsed); if (DErrLimit()) return False;
+		nerrBefore = nerr;
+		DCheckVoiceTable(doc, maxCheck, &nvUsed);
+		DNotePass(pResults, "DCheckVoiceTable", nerrBefore);
+		if (!headless && DErrLimit()) goto Stopped;
 	}
 
-	(void)DCheckHeirarchy(doc);				if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckJDOrder(doc);				if (DErrLimit() || UserInterrupt()) return False;
-
-	(void)DCheckBeams(doc, maxCheck);		if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckOttavas(doc);				if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckSlurs(doc);					if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckTuplets(doc, maxCheck);		if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckHairpins(doc);				if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckContext(doc);				if (DErrLimit() || UserInterrupt()) return False;
+	nerrBefore = nerr;  (void)DCheckHeirarchy(doc);
+	DNotePass(pResults, "DCheckHeirarchy", nerrBefore);		if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckJDOrder(doc);
+	DNotePass(pResults, "DCheckJDOrder", nerrBefore);		if (DStopChecking(headless)) goto Stopped;
+
+	nerrBefore = nerr;  (void)DCheckBeams(doc, maxCheck);
+	DNotePass(pResults, "DCheckBeams", nerrBefore);			if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckOttavas(doc);
+	DNotePass(pResults, "DCheckOttavas", nerrBefore);		if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckSlurs(doc);
+	DNotePass(pResults, "DCheckSlurs", nerrBefore);			if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckTuplets(doc, maxCheck);
+	DNotePass(pResults, "DCheckTuplets", nerrBefore);		if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckHairpins(doc);
+	DNotePass(pResults, "DCheckHairpins", nerrBefore);		if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckContext(doc);
+	DNotePass(pResults, "DCheckContext", nerrBefore);		if (DStopChecking(headless)) goto Stopped;
 
 	/* PART 3. Check that musical and music-notation constraints are obeyed. */
 	
-	(void)DCheckPlayDurs(doc, maxCheck);	if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckTempi(doc);					if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckRedundantKS(doc);			if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckExtraTS(doc);				if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckCautionaryTS(doc);			if (DErrLimit() || UserInterrupt()) return False;
+	nerrBefore = nerr;  (void)DCheckPlayDurs(doc, maxCheck);
+	DNotePass(pResults, "DCheckPlayDurs", nerrBefore);		if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckTempi(doc);
+	DNotePass(pResults, "DCheckTempi", nerrBefore);			if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckRedundantKS(doc);
+	DNotePass(pResults, "DCheckRedundantKS", nerrBefore);	if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckExtraTS(doc);
+	DNotePass(pResults, "DCheckExtraTS", nerrBefore);		if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckCautionaryTS(doc);
+	DNotePass(pResults, "DCheckCautionaryTS", nerrBefore);	if (DStopChecking(headless)) goto Stopped;
 	if (maxCheck) {
-		(void)DCheckMeasDur(doc);			if (DErrLimit() || UserInterrupt()) return False;
+		nerrBefore = nerr;  (void)DCheckMeasDur(doc);
+		DNotePass(pResults, "DCheckMeasDur", nerrBefore);	if (DStopChecking(headless)) goto Stopped;
 	}
-	(void)DCheckUnisons(doc, maxCheck);		if (DErrLimit() || UserInterrupt()) return False;
-	(void)DCheckNoteNums(doc);				if (DErrLimit() || UserInterrupt()) return False;
+	nerrBefore = nerr;  (void)DCheckUnisons(doc, maxCheck);
+	DNotePass(pResults, "DCheckUnisons", nerrBefore);		if (DStopChecking(headless)) goto Stopped;
+	nerrBefore = nerr;  (void)DCheckNoteNums(doc);
+	DNotePass(pResults, "DCheckNoteNums", nerrBefore);		if (DStopChecking(headless)) goto Stopped;
 
+	nerrBefore = nerr;
 	if (DCheckSel(doc, &nInRange, &nSel)) return True;
+	DNotePass(pResults, "DCheckSel", nerrBefore);
 	
 #ifdef DDB
 	strictCont = ContinSelection(doc, True);
@@ -123,15 +218,18 @@ Boolean DCheckEverything(Document *doc,
 
 	LogPrintf(LOG_INFO, "--CHECK MASTER: ");
 #endif
+	nerrBefore = nerr;
 	for (pL = doc->masterHeadL; pL!=doc->masterTailL; pL = RightLINK(pL)) {
 		if (DCheckNode(doc, pL, MP_DSTR, maxCheck)<0) return True;
-		DCheckNodeSel(doc, pL);			if (DErrLimit() || UserInterrupt()) return False;
+		DCheckNodeSel(doc, pL);			if (DStopChecking(headless)) goto Stopped;
 	}
+	DNotePass(pResults, "DCheckNode (Master Page)", nerrBefore);
 #ifdef DDB
 	LogPrintf(LOG_INFO, " Done.\n");
 #endif
 	
 	LogPrintf(LOG_INFO, "--CHECK CLIPBOARD: ");
+	nerrBefore = nerr;
 	InstallDoc(clipboard);
 	for (pL = clipboard->headL; pL!=clipboard->tailL; pL = RightLINK(pL))
 		if (DCheckNode(clipboard, pL, CLIP_DSTR, maxCheck)<0) {
@@ -139,6 +237,7 @@ Boolean DCheckEverything(Document *doc,
 			return True;
 		}
 	InstallDoc(doc);
+	DNotePass(pResults, "DCheckNode (Clipboard)", nerrBefore);
 
 #ifdef DDB
 	LogPrintf(LOG_INFO, " Done.");
@@ -146,6 +245,9 @@ Boolean DCheckEverything(Document *doc,
 	LogPrintf(LOG_INFO, "\n");
 #endif
 
+Stopped:
+	pResults->fatal = False;
+	pResults->nErrors = nerr;
 	return False;
 }
 
@@ -504,6 +504,11 @@ short SaveFile(
 	if (!SFChkScoreOK(doc))
 		{ errInfo = NENTRIESerr; goto Error; }
 
+	/* Squeeze garbage and duplicates out of the string pool. If it fails, it's
+	   harmless, so don't complain. */
+	
+	(void)CompactStringPool(doc);
+
 	Pstrcpy(filename,doc->name);
 	vRefNum = doc->vrefnum;
 	fsSpec = doc->fsSpec;
@@ -577,7 +577,7 @@ PushLock(OBJheap);
 		pGraphic = GetPGRAPHIC(newpL);
 		aGraphicL = FirstSubLINK(newpL);
 
-		offset = PStore(CToPString(str));
+		offset = PIntern(CToPString(str));
 		if (offset<0L) {
 			NoMoreMemory();
 			goto cleanup;
@@ -1205,7 +1205,7 @@ static short CreateHyphenRun(
 			aGraphicL = FirstSubLINK(firstSylL);
 			Pstrcpy((unsigned char *)hyphStr, PCopy(GraphicSTRING(aGraphicL)));
 			PStrCat((StringPtr)hyphStr, (StringPtr)"\p-");
-			offset = PStore((unsigned char *)hyphStr);
+			offset = PIntern((unsigned char *)hyphStr);
 			if (offset<0L) {
 				NoMoreMemory();						/* FIXME: but we've destroyed a syllable! */
 				return -1;
@@ -780,11 +780,11 @@ PushLock(GRAPHICheap);
 		aGraphicL = FirstSubLINK(newL);
 		aGraphic = GetPAGRAPHIC(aGraphicL);
 		aGraphic->next = NILINK;
-		aGraphic->strOffset = PStore((unsigned char *)string);
+		aGraphic->strOffset = PIntern((unsigned char *)string);
 		if (aGraphic->strOffset<0L)
 			NoMoreMemory();
 		else if (aGraphic->strOffset>GetHandleSize((Handle)doc->stringPool))
-			MayErrMsg("NewGraphic: PStore error. string=%ld", aGraphic->strOffset);
+			MayErrMsg("NewGraphic: PIntern error. string=%ld", aGraphic->strOffset);
 	}
 
 	if (graphicType==GRLyric || graphicType==GRString) {
@@ -1687,13 +1687,13 @@ PushLock(OBJheap);
 	pTempo->dotted = dotted;
 	pTempo->noMM = !useMM;
 	pTempo->hideMM = !showMM;
-	pTempo->strOffset = PStore((unsigned char *)tempoStr);	/* index return by String Manager */
-	pTempo->metroStrOffset = PStore((unsigned char *)metroStr);	/* index return by String Manager */
+	pTempo->strOffset = PIntern((unsigned char *)tempoStr);	/* index return by String Manager */
+	pTempo->metroStrOffset = PIntern((unsigned char *)metroStr);	/* index return by String Manager */
 	if (pTempo->strOffset<0L || pTempo->metroStrOffset<0L)
 		NoMoreMemory();
 	else if (pTempo->strOffset>GetHandleSize((Handle)doc->stringPool)
 		  || pTempo->metroStrOffset>GetHandleSize((Handle)doc->stringPool))
-		MayErrMsg("NewTempo: PStore error. strOffset=%ld metroStrOffset=%ld",
+		MayErrMsg("NewTempo: PIntern error. strOffset=%ld metroStrOffset=%ld",
 					pTempo->strOffset, pTempo->metroStrOffset);
 
 	if (!useMM) pTempo->tempoMM = 0;
@@ -636,13 +636,13 @@ getStyle:
 PopLock(OBJheap);
 	
 	CToPString(string);
-	strOffset = PStore((unsigned char *)string);
+	strOffset = PIntern((unsigned char *)string);
 	if (strOffset<0L) {
 		NoMoreMemory();
 		return NILINK;
 	}
 	else if (strOffset>GetHandleSize((Handle)doc->stringPool)) {
-		MayErrMsg("IIInsertGRString: PStore error. string=%ld", strOffset);
+		MayErrMsg("IIInsertGRString: PIntern error. string=%ld", strOffset);
 		return NILINK;
 	}
 	aGraphicL = FirstSubLINK(graphicL);
@@ -691,10 +691,10 @@ PushLock(OBJheap);
 	pTempo->firstObjL = anchorL;
 	
 	CToPString(tempoStr);
-	pTempo->strOffset = PStore((unsigned char *)tempoStr);
+	pTempo->strOffset = PIntern((unsigned char *)tempoStr);
 
 	CToPString(metroStr);	
-	pTempo->metroStrOffset = PStore((unsigned char *)metroStr);
+	pTempo->metroStrOffset = PIntern((unsigned char *)metroStr);
 	
 	if (pTempo->strOffset<0L || pTempo->metroStrOffset<0L) {
 		NoMoreMemory();
@@ -702,7 +702,7 @@ PushLock(OBJheap);
 	}
 	else if (pTempo->strOffset>GetHandleSize((Handle)doc->stringPool)
 		  || pTempo->metroStrOffset>GetHandleSize((Handle)doc->stringPool)) {
-		MayErrMsg("IIInsertTempo: PStore error. strOffset=%ld metroStrOffset=%ld",
+		MayErrMsg("IIInsertTempo: PIntern error. strOffset=%ld metroStrOffset=%ld",
 					pTempo->strOffset, pTempo->metroStrOffset);
 		tempoL = NILINK;
 	}
@@ -27,11 +27,21 @@ static MIDIEvent	eventList[MAXMFEVENTLIST];
 static short		lastEvent;
 
 static long 		qtrNTicks,				/* Ticks per quarter in Nightingale */
-					trackLength,
-					lenPosition;			/* File pos. of length field of current chunk */
+					trackLength;			/* Bytes of current track in <trackBuf> so far */
 static DoubleWord	curTime;
 
+/* Each track is built in memory in <trackBuf>, then written to the file with its chunk
+header in one call; that way we never have to seek back to fill in the track length,
+and we make a single FSWrite per track instead of one per event. The buffer is kept
+between tracks, and grows geometrically so a long track costs only a few resizes. */
+
+#define MF_TRACKBUF_INITSIZE	16384L		/* Initial size of <trackBuf>, in bytes */
+
+static Handle		trackBuf;
+static long			trackBufSize;			/* Current allocated size of <trackBuf> */
+
 static Boolean	WriteChunkStart(DoubleWord, DoubleWord);
+static Boolean	MFPutBytes(const void *, long);
 static Boolean	WriteVarLen(DoubleWord);
 static Boolean	WriteDeltaTime(DoubleWord);
 
@@ -45,9 +55,6 @@ static Boolean WriteChunkStart(DoubleWord chunkType, DoubleWord len)
 {
 	long byteCount;  DoubleWord data[2];
 	
-	GetFPos(fRefNum, &lenPosition);
-	lenPosition += sizeof(DoubleWord);
-	
 	data[0] = chunkType;
 	data[1] = len;
 	byteCount = 2*sizeof(DoubleWord);
@@ -57,6 +64,40 @@ static Boolean WriteChunkStart(DoubleWord chunkType, DoubleWord len)
 }
 
 
+/* ------------------------------------------------------------------------ MFPutBytes -- */
+/* Append <nBytes> bytes to the track being built in <trackBuf>, enlarging it if
+necessary. Return True if all is well, False if we run out of memory. Once an append
+fails, <errCode> stays set and every later append fails too, so the caller can't write
+out a track with a hole in it. */
+
+static Boolean MFPutBytes(const void *data, long nBytes)
+{
+	long newSize;
+	
+	if (errCode!=noErr) return False;
+
+	if (trackLength+nBytes>trackBufSize) {
+		newSize = (trackBufSize>0L? 2L*trackBufSize : MF_TRACKBUF_INITSIZE);
+		while (newSize<trackLength+nBytes)
+			newSize *= 2L;
+		if (trackBuf==NULL) {
+			trackBuf = NewHandle(newSize);
+			if (!GoodNewHandle(trackBuf)) { trackBuf = NULL; errCode = memFullErr; return False; }
+		}
+		else {
+			SetHandleSize(trackBuf, newSize);
+			errCode = MemError();
+			if (errCode!=noErr) return False;
+		}
+		trackBufSize = newSize;
+	}
+
+	BlockMoveData(data, *trackBuf+trackLength, nBytes);
+	trackLength += nBytes;
+	return True;
+}
+
+
 /* ----------------------------------------------------------------------- WriteVarLen -- */
 /* Write <value> out as a MIDI file "variable-length number" and return True.
 
@@ -65,7 +106,7 @@ or if we have trouble writing it, return False. */
 
 static Boolean WriteVarLen(DoubleWord value)
 {
-	long buffer, byteCount;  Byte b;
+	long buffer, byteCount;  Byte b[4];
 	
 	if (value<0 || value>0x0FFFFFFF) return False;
 
@@ -76,17 +117,15 @@ static Boolean WriteVarLen(DoubleWord value)
 		buffer += (value & 0x7F);			/* put 7-bit value in buffer */
 	}
 
-	byteCount = 1;	
+	byteCount = 0;	
 	while (True) {
-		b = (Byte)buffer;					/* truncate to lowest byte */
-		errCode = FSWrite(fRefNum, &byteCount, &b); 
-		trackLength += byteCount;
+		b[byteCount++] = (Byte)buffer;		/* truncate to lowest byte */
 		   
 		if (buffer & 0x80)	buffer >>= 8;
 		else				break;
 	}
 	
-	return (errCode==noError);
+	return MFPutBytes(b, byteCount);
 }
 
 
@@ -114,7 +153,7 @@ static Boolean WriteTempoEvent(unsigned long);
 static Boolean WriteTSEvent(short, short, short);
 static Boolean WriteTextEvent(Byte, char []);
 static Boolean WriteControlChange(Byte channel, Byte ctrlNum, Byte ctrlValue);
-static Boolean FillInTrackLength(void);
+static Boolean WriteTrackChunk(void);
 
 static Boolean WriteNote(Byte, Byte, Byte);
 static Boolean WriteNoteOn(Byte, Byte, Byte);
@@ -157,9 +196,7 @@ static Boolean WriteTrackEnd()
 	buffer[2] = (Byte)0;
 
 	byteCount = 3L;
-	errCode = FSWrite(fRefNum, &byteCount, buffer); 
-	trackLength += byteCount;
-	return (errCode==noError);
+	return MFPutBytes(buffer, byteCount);
 }	
 
 static Boolean WriteTempoEvent(
@@ -178,9 +215,7 @@ static Boolean WriteTempoEvent(
 	buffer[5] = (Byte)microsecPQ;
 
 	byteCount = 6L;
-	errCode = FSWrite(fRefNum, &byteCount, buffer); 
-	trackLength += byteCount;
-	return (errCode==noError);
+	return MFPutBytes(buffer, byteCount);
 }	
 
 static Boolean WriteTSEvent(short numerator, short denominator, short clocksPerBeat)
@@ -205,9 +240,7 @@ static Boolean WriteTSEvent(short numerator, short denominator, short clocksPerB
 	buffer[6] = thirtySeconds;
 
 	byteCount = 7L;	
-	errCode = FSWrite(fRefNum, &byteCount, buffer); 
-	trackLength += byteCount;
-	return (errCode==noError);
+	return MFPutBytes(buffer, byteCount);
 }	
 
 
@@ -228,9 +261,7 @@ static Boolean WriteTextEvent(Byte mEventType,
 	}
 
 	byteCount = 3L+buffer[2];
-	errCode = FSWrite(fRefNum, &byteCount, buffer); 
-	trackLength += byteCount;
-	return (errCode==noError);
+	return MFPutBytes(buffer, byteCount);
 }	
 
 static Boolean WriteControlChange(Byte channel, Byte ctrlNum, Byte ctrlValue)
@@ -243,28 +274,23 @@ static Boolean WriteControlChange(Byte channel, Byte ctrlNum, Byte ctrlValue)
 	buffer[2] = ctrlValue;
 
 	byteCount = 3L;	
-	errCode = FSWrite(fRefNum, &byteCount, buffer); 
-	trackLength += byteCount;
-	return (errCode==noError);
+	return MFPutBytes(buffer, byteCount);
 }
 
-static Boolean FillInTrackLength()
-{
-	long byteCount, savePosition;
-	
-	GetFPos(fRefNum, &savePosition);
+/* Write the track we've built in <trackBuf> to the file: the chunk header, now that
+we know the track's length, followed by the track's contents in a single call. */
 
-	/* Position file pointer at track length (previously filled with dummy value) */
+static Boolean WriteTrackChunk()
+{
+	long byteCount;
 	
-	errCode = SetFPos(fRefNum, fsFromStart, lenPosition);
-	if (errCode!=noErr) return False;
-	byteCount = sizeof(trackLength);
-	errCode = FSWrite(fRefNum, &byteCount, &trackLength); 
-	if (errCode!=noErr) return False;
+	if (!WriteChunkStart('MTrk', trackLength)) return False;
+	if (trackLength<=0L) return True;
 
-	/* Move back to where we just were so as not to truncate anything */
-	
-	errCode = SetFPos(fRefNum, fsFromStart, savePosition);
+	byteCount = trackLength;
+	HLock(trackBuf);
+	errCode = FSWrite(fRefNum, &byteCount, *trackBuf);
+	HUnlock(trackBuf);
 	return (errCode==noError);
 }	
 
@@ -279,9 +305,7 @@ static Boolean WriteNote(Byte midiEvent, Byte noteNum, Byte veloc)
 	buffer[2] = veloc;
 
 	byteCount = 3L;	
-	errCode = FSWrite(fRefNum, &byteCount, buffer); 
-	trackLength += byteCount;
-	return (errCode==noError);
+	return MFPutBytes(buffer, byteCount);
 }	
 
 static Boolean WriteNoteOn(Byte channel, Byte noteNum, Byte velocity)
@@ -527,7 +551,9 @@ static void WriteAllMIDIPans(Document *doc, Byte *partChannel, long startTime, L
 /* -------------------------------------------------------------- Event List functions -- */
 
 static Boolean	MFInsertEvent(char, char, long);
-static void		MFCheckEventList(long);
+static long		MFNextEndTime(void);
+static Boolean	MFCheckEventList(long);
+static Boolean	MFFlushNoteOffs(long, long);
 
 /*	Insert the specified note into the event list. Return True normally, False in case
 of trouble. */
@@ -566,10 +592,27 @@ static Boolean MFInsertEvent(
 }
 
 
+/*	Return the earliest ending time of any note in eventList[], or BIGNUM if there are
+no notes in the list. */
+
+static long MFNextEndTime()
+{
+	MIDIEvent	*pEvent;
+	short		i;
+	long		nextTime = BIGNUM;
+	
+	for (i=0, pEvent = eventList; i<lastEvent; i++, pEvent++)
+		if (pEvent->note && pEvent->endTime<nextTime) nextTime = pEvent->endTime;
+
+	return nextTime;
+}
+
+
 /*	Checks eventList[] to see if any notes are ready to be turned off; if so, frees
-their slots in the eventList and writes out Note Offs. */
+their slots in the eventList and writes out Note Offs. Return False if we can't write
+one, else True. */
 
-static void MFCheckEventList(long time)
+static Boolean MFCheckEventList(long time)
 {
 	MIDIEvent	*pEvent;
 	short		i;
@@ -577,14 +620,35 @@ static void MFCheckEventList(long time)
 	for (i=0, pEvent = eventList; i<lastEvent; i++, pEvent++)
 		if (pEvent->note) {
 			if (pEvent->endTime<=time) {						/* note is done */
-					WriteDeltaTime(time);
-					if (!WriteNoteOff(pEvent->channel, pEvent->note)) {
-						MayErrMsg("Unable to write Note Off to MIDI file.  (MFCheckEventList)");
-						return;
-					}
+				WriteDeltaTime(time);
+				if (!WriteNoteOff(pEvent->channel, pEvent->note)) {
+					MayErrMsg("Unable to write Note Off to MIDI file.  (MFCheckEventList)");
+					return False;
+				}
 				pEvent->note = 0;								/* slot available now */
 			}
 		}
+
+	return True;
+}
+
+
+/*	Write Note Offs, in order of time, for every note in eventList[] that ends at or
+before <toTime>. We've already handled everything before <fromTime>, so any note that
+"ends" earlier than that (e.g., one of zero duration) is turned off at <fromTime>.
+Return False if the user cancels or we can't write a Note Off, else True. */
+
+static Boolean MFFlushNoteOffs(long fromTime, long toTime)
+{
+	long endTime;
+	
+	while ((endTime = MFNextEndTime())<=toTime) {
+		if (UserInterrupt()) return False;		/* Check for Cancel */
+		if (endTime<fromTime) endTime = fromTime;
+		if (!MFCheckEventList(endTime)) return False;	/* Turn off the notes that end then */
+	}
+	
+	return True;
 }
 
 
@@ -792,8 +856,10 @@ static Boolean WriteTrackPatch(Document *doc, short staffn)
 	buffer[0] = MPGMCHANGE+channel-CM_CHANNEL_BASE;
 	buffer[1] = patch;
 	byteCount = 2L;	
-	errCode = FSWrite(fRefNum, &byteCount, buffer); 
-	trackLength += byteCount;
+	if (!MFPutBytes(buffer, byteCount)) {
+		MayErrMsg("Unable to write patch change to MIDI file.  (WriteTrackPatch)");
+		return False;
+	}
 	if (DETAIL_SHOW) LogPrintf(LOG_DEBUG,
 			"  WriteTrackPatch: staff=%d patch=%d channel=%d buffer[]=%d %d errCode=%d\n",
 								staffn, patch, channel, buffer[0], buffer[1], errCode);
@@ -894,12 +960,12 @@ static short WriteMFNotes(
 				   check for notes ending before _or at_ pL's time and take care of them.
 				   We have to write notes ending at a given time before those beginning
 				   at the same time because otherwise--if there's a new note of the same
-				   note number--we'll end up making a note start, then end instantly. */
+				   note number--we'll end up making a note start, then end instantly.
+				   Rather than step through every tick, jump straight to the next time
+				   any note ends: the Note Offs come out in the same order either way. */
 				   
-				for ( ; t<=startTime; t++) {
-					if (UserInterrupt()) goto Done;		/* Check for Cancel */
-					MFCheckEventList(t);				/* Check for and turn off any notes that are done */
-				}
+				if (!MFFlushNoteOffs(t, startTime)) goto Done;
+				if (t<=startTime) t = startTime+1;
 
 				if (newMeasL) {
 					newMeasL = NILINK;
@@ -1018,10 +1084,8 @@ static short WriteMFNotes(
 		}
 	}
 			
-	for ( ; t<=trkLastEndTime; t++) {
-		if (UserInterrupt()) goto Done;				/* Check for Cancel */
-		MFCheckEventList(t);						/* Check for and turn off any notes that are done */
-	}
+	if (!MFFlushNoteOffs(t, trkLastEndTime)) goto Done;
+	if (t<=trkLastEndTime) t = trkLastEndTime+1;
 
 Done:	
 	WriteDeltaTime(t);
@@ -1048,11 +1112,9 @@ static Boolean WriteTrack(
 	short staffn, nZeroVel, partPatch, channel;
 	PARTINFO aPart;
 	
-	trackLength = 0L;
+	trackLength = 0L;								/* Start with an empty <trackBuf> */
 	curTime = 0L;
 
-	WriteChunkStart('MTrk', 0L);					/* Dummy tracklength: fill in later */
-
 	if (trackn==1) {
 		if (WriteTimingTrack(doc, trkLastEndTime))
 			LogPrintf(LOG_NOTICE, "Wrote timing track. trkLastEndTime=%d\n",
@@ -1061,7 +1123,10 @@ static Boolean WriteTrack(
 	else {
 		staffn = trackn-1;
 		WriteTrackName(doc, staffn);
-		WriteTrackPatch(doc, staffn);
+		if (!WriteTrackPatch(doc, staffn)) {
+			*pnZeroVel = 0;
+			return False;
+		}
 		nZeroVel = WriteMFNotes(doc, staffn, doc->headL, doc->tailL, trkLastEndTime);
 		aPartL = Staff2PartL(doc, doc->headL, staffn);
 		aPart = GetPARTINFO(aPartL);
@@ -1073,7 +1138,7 @@ static Boolean WriteTrack(
 		LogPrintf(LOG_NOTICE, "  (WriteTrack)\n");
 	}
 
-	FillInTrackLength();
+	if (errCode==noErr) WriteTrackChunk();
 	
 	if (errCode!=noErr) ReportIOError(errCode, SAVEMF_ALRT);
 	
@@ -1144,6 +1209,7 @@ static Boolean WriteMIDIFile(Document *doc)
 {
 	short t, nZeroVel;
 	long trkLastEndTime;							/* The latest ending time for any track */
+	Boolean okay;
 
 	/* Write the MIDI file header, then the tracks, one for timing info plus one for
 	   each staff of the score. */
@@ -1164,10 +1230,14 @@ static Boolean WriteMIDIFile(Document *doc)
 	
 	trkLastEndTime = LastEndTime(doc, doc->headL, doc->tailL);
 	
+	okay = True;
 	for (t = 1; t<=mfNTracks; t++)		
-		if (!WriteTrack(doc, t, trkLastEndTime, &nZeroVel)) return False;
+		if (!WriteTrack(doc, t, trkLastEndTime, &nZeroVel)) { okay = False; break; }
 	
-	return True;
+	if (trackBuf) DisposeHandle(trackBuf);
+	trackBuf = NULL;
+	trackBufSize = 0L;
+	return okay;
 }
 
 
@@ -493,6 +493,108 @@ Boolean RecordDialog(
 
 Boolean BIMIDINoteAtTime(short noteNum, short channel, short velocity, long time);
 
+/* ------------------------------------------------------- Pairing Note Ons with Offs -- */
+/* Finding the Note Off for each Note On by searching forward from it through the
+packet list, as FillCMMNote used to do for every note, takes time proportional to the
+square of the length of the take, all of it after the user stops recording. Instead,
+we pair them incrementally while recording is in progress: each time RecordBuffer
+moves new packets into the packet list, PairRecNotes looks at just those packets,
+keeping a first-in-first-out queue of unmatched Note Ons for each channel and note
+number. When recording ends, MIDI2Night's work is then linear in the number of notes. */
+
+#define MAX_REC_NOTEONS (kCMBufLen/(CMPKT_HDR_SIZE+kNoteOnLen))	/* Can't be more in packet list */
+
+typedef struct {
+	MIDIPacket	*onPkt;					/* Note On packet */
+	MIDIPacket	*offPkt;				/* Its Note Off packet, or NULL if none (yet) */
+	short		nextPending;			/* Next unmatched Note On for same chan./note no. */
+} RECNOTEON;
+
+static RECNOTEON	recNoteTab[MAX_REC_NOTEONS];
+static short		nRecNoteOns;
+static short		recPendHead[MAXCHANNEL][MAX_NOTENUM+1],	/* Queues of unmatched Note Ons */
+					recPendTail[MAXCHANNEL][MAX_NOTENUM+1];
+static MIDIPacket	*recPairScanPkt;	/* First packet PairRecNotes hasn't looked at */
+static Boolean		recPairOverflow;	/* Too many Note Ons: FillCMMNote must search */
+static short		recLookupIdx;		/* Where FindRecNoteOn starts looking */
+
+static void InitRecNotePairing(void);
+static void PairRecNotes(void);
+static RECNOTEON *FindRecNoteOn(MIDIPacket *);
+
+/* Call this whenever the packet list is reset. */
+
+static void InitRecNotePairing()
+{
+	short c, n;
+	
+	for (c = 0; c<MAXCHANNEL; c++)
+		for (n = 0; n<=MAX_NOTENUM; n++)
+			recPendHead[c][n] = recPendTail[c][n] = -1;
+	nRecNoteOns = 0;
+	recPairScanPkt = gCurrPktListBegin;
+	recPairOverflow = False;
+	recLookupIdx = 0;
+}
+
+/* Pair up Note Ons and Note Offs in the packets that have been added to the packet list
+since the last call. */
+
+static void PairRecNotes()
+{
+	MIDIPacket *p;
+	Byte command, channel, noteNum;
+	short n;
+	
+	if (recPairOverflow || recPairScanPkt==NULL) return;
+
+	for (p = recPairScanPkt; p<gCurrPktListEnd; p = MIDIPacketNext(p)) {
+		if (p->length<kNoteOnLen) continue;
+		command = p->data[0] & MCOMMANDMASK;
+		channel = p->data[0] & MCHANNELMASK;
+		noteNum = p->data[1] & MAX_NOTENUM;
+		
+		if (command==MNOTEON && p->data[2]!=0) {
+			if (nRecNoteOns>=MAX_REC_NOTEONS) {
+				recPairOverflow = True;
+				break;
+			}
+			n = nRecNoteOns++;
+			recNoteTab[n].onPkt = p;
+			recNoteTab[n].offPkt = NULL;
+			recNoteTab[n].nextPending = -1;
+			if (recPendTail[channel][noteNum]<0)
+				recPendHead[channel][noteNum] = n;
+			else
+				recNoteTab[recPendTail[channel][noteNum]].nextPending = n;
+			recPendTail[channel][noteNum] = n;
+		}
+		else if (command==MNOTEOFF || command==MNOTEON) {				/* Note On w/vel. 0 = Note Off */
+			n = recPendHead[channel][noteNum];
+			if (n>=0) {
+				recNoteTab[n].offPkt = p;
+				recPendHead[channel][noteNum] = recNoteTab[n].nextPending;
+				if (recPendHead[channel][noteNum]<0) recPendTail[channel][noteNum] = -1;
+			}
+		}
+	}
+	
+	recPairScanPkt = p;
+}
+
+/* Return the pairing table entry for Note On packet <p>, or NULL if there isn't one.
+Assumes calls are made in packet-list order, as MIDI2Night does. */
+
+static RECNOTEON *FindRecNoteOn(MIDIPacket *p)
+{
+	while (recLookupIdx<nRecNoteOns && recNoteTab[recLookupIdx].onPkt<p)
+		recLookupIdx++;
+	if (recLookupIdx<nRecNoteOns && recNoteTab[recLookupIdx].onPkt==p)
+		return &recNoteTab[recLookupIdx];
+	return NULL;
+}
+
+
 /* ---------------------------------------------------------------------- FillOMSMNote -- */
 
 static Boolean FillCMMNote(MIDIPacket *p, Byte channel, MNOTEPTR pMNote)
@@ -500,6 +602,7 @@ static Boolean FillCMMNote(MIDIPacket *p, Byte channel, MNOTEPTR pMNote)
 	Byte vNOff, vNOn; 		/* status bytes for Note Off/On on correct channel */
 	Boolean	first, done;
 	MIDIPacket *nextP;
+	RECNOTEON *pRecNoteOn;
 	short command;							
 	register long offTime;
 	char fmtStr[256];
@@ -518,6 +621,26 @@ static Boolean FillCMMNote(MIDIPacket *p, Byte channel, MNOTEPTR pMNote)
 		return False;
 
 	done = False;
+
+	/* If PairRecNotes has already found this note's Note Off, just use it. */
+	
+	pRecNoteOn = FindRecNoteOn(p);
+	if (pRecNoteOn) {
+		nextP = pRecNoteOn->offPkt;
+		if (nextP) {
+			offTime = CMTimeStampToMillis(nextP->timeStamp);		/* Get milliseconds */
+			pMNote->duration = offTime-pMNote->startTime;
+			if (pMNote->onVelocity<config.minRecVelocity			/* Too soft and */
+					&& pMNote->duration<config.minRecDuration)		/*   too short? */
+				 return False;
+			if ((nextP->data[0] & MCOMMANDMASK)==MNOTEOFF)
+				pMNote->offVelocity = nextP->data[2];
+			nextP->data[0] = 0;										/* As DeletePeekedAtCMMIDIPacket does */
+			done = True;
+		}
+		goto CheckDone;
+	}
+
 	first = True;
 	while ((nextP = PeekAtNextCMMIDIPacket(first)) && !done)
 	{
@@ -562,6 +685,7 @@ static Boolean FillCMMNote(MIDIPacket *p, Byte channel, MNOTEPTR pMNote)
 		first = False;
 	}
 
+CheckDone:
 	if (!done) {
 		GetIndCString(fmtStr, MIDIERRS_STRS, 2);					/* "No Note Off for Note On" */
 		sprintf(strBuf, fmtStr, pMNote->startTime/1000L, pMNote->startTime%1000L,
@@ -756,6 +880,8 @@ static long MIDI2Night(
 	if (useWhichMIDI == MIDIDR_CM) {
 		SetCMMIDIPacket();
 		CMNormalizeTimeStamps();
+		PairRecNotes();										/* Pair anything that came in at the end */
+		recLookupIdx = 0;
 	}
 	 
 	while (True) {
@@ -957,7 +1083,12 @@ static void RecordBuffer(
 
 		switch (useWhichMIDI) {
 			case MIDIDR_CM:
-				/* Nothing but UI to do here: all else is done at interrupt level in NightOMSReadHook */
+				/* NightCMReadProc puts incoming packets into the input ring; move them
+				   into the packet list as we go, so the ring never has to hold more
+				   than what arrives between passes through this loop. */
+				   
+				mRecIndex += DrainCMInputRing();
+				PairRecNotes();
 				if (gCMMIDIBufferFull) {
 					GetIndCString(fmtStr, MIDIERRS_STRS, 26);	/* "Reached the limit of %d MIDI packets in one take" */
 					sprintf(strBuf, fmtStr, mRecIndex);
@@ -1091,6 +1222,7 @@ Boolean Record(Document *doc)
 			NoMoreMemory();
 			goto Finished;
 		}
+		InitRecNotePairing();
 	}
 		
 	LogPrintf(LOG_INFO, "2. CoreMIDI set up...\n");
@@ -1597,7 +1729,7 @@ short GetAllNoteOns(NotePacket nOnBuffer[],
 				for (i = 0; i<pCM->length; i++)
 					nOnBuffer[n].data[i] = pCM->data[i];
 					
-				LogPrintf(LOG_NOTICE, "kk %ld nOnBufPos %ld n %ld tstamp %ld\n", kk, nOnBufPos, n, nOnBuffer[n].tStamp);
+				LOGPRINTF_LIMITED(LOG_NOTICE, "kk %ld nOnBufPos %ld n %ld tstamp %ld\n", kk, nOnBufPos, n, nOnBuffer[n].tStamp);
 				
 				n++;
 			}
@@ -1635,7 +1767,7 @@ short FindDeflamGap(Document *doc, NotePacket nOnBuffer[], short nOnBufLen, long
 		else 
 			nChord = 0;
 		
-		LogPrintf(LOG_NOTICE, "jj %ld lastTimeStamp %ld startBufferTime %ld nowTime %ld nowGap %ld nChord %ld \n", 
+		LOGPRINTF_LIMITED(LOG_NOTICE, "jj %ld lastTimeStamp %ld startBufferTime %ld nowTime %ld nowGap %ld nChord %ld \n", 
 						 jj, lastTimeStamp, startBufferTime, nowTime, nowGap, nChord);
 		return nChord;
 	}
@@ -2136,6 +2268,7 @@ Boolean RTMRecord(Document *doc)
 			NoMoreMemory();
 			goto Finished;
 		}
+		InitRecNotePairing();
 	}
 		
 	SetRecordFlats(doc);
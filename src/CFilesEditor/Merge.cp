@@ -2450,6 +2450,8 @@ void DoMerge(Document *doc)
 	short mergeType, stfDiff, partDiff, stfOff, mergeErr;
 	VInfo vInfo[MAXVOICES+1];
 
+	PROF_SCOPE("DoMerge");
+
 	if (doc->selStartL==doc->tailL) {
 	
 		/* In this case, we simply paste at the end of the score. DoPaste is a user-
@@ -2546,6 +2548,8 @@ void DoPasteAsCue(Document *doc, short voice, short velocity)
 	short mergeType, stfDiff, partDiff, stfOff, mergeErr;
 	VInfo vInfo[MAXVOICES+1];
 
+	PROF_SCOPE("DoPasteAsCue");
+
 	if (doc->selStartL==doc->tailL) {
 	
 		/* In this case, we simply paste at the end of the score. DoPasteAsCue is a user-
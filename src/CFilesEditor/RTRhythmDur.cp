@@ -221,9 +221,38 @@ Boolean ClarAllToMeas(
 
 /* -------------------------------------------------------------------- Handle Tuplets -- */
 
+/* ChooseAllTuplets sets this if the times in rawSyncTab[] are in non-decreasing order,
+as they should always be at that point; if so, FindTimeRange can use binary search. */
+
+static Boolean rawTimesSorted = False;
+
+static short FirstTimeAtOrAfter(long, LINKTIMEINFO [], short, Boolean);
+
+/* Return the index of the first NRC in rawSyncTab[] (which must be sorted by time)
+whose time is >= <time>, or if <strictly>, > <time>. If there is none, return
+<nRawSyncs>. */
+
+static short FirstTimeAtOrAfter(long time, LINKTIMEINFO rawSyncTab[], short nRawSyncs,
+									Boolean strictly)
+{
+	short lo = 0, hi = nRawSyncs, mid;
+	
+	while (lo<hi) {
+		mid = (lo+hi)/2;
+		if (rawSyncTab[mid].time<time || (strictly && rawSyncTab[mid].time==time))
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	
+	return lo;
+}
+
+
 /* Return the indices of the range of NRCs in rawSyncTab[] that fall partly or entirely
 in the range of times [startTime,endTime); if there are none, return both indices <0.
-NB: nRawSyncs might be pretty big: it would be better to use binary search for speed. */
+nRawSyncs might be pretty big and we're called for every beat of every measure at each
+tuplet level, so if the times are known to be sorted, use binary search. */
 
 void FindTimeRange(
 		long startTime, long endTime,
@@ -232,10 +261,25 @@ void FindTimeRange(
 		short *pStart, short *pEnd 	/* 1st entry in range, 1st AFTER range: -1=none in range */
 		)
 {
-	short q, qEndTime;
+	short q, qAfter;  long qEndTime;
 	
 	*pStart = *pEnd = -1;
 	
+	if (rawTimesSorted) {
+		/* The first item that ENDS in the range is the one just before the first that
+		   starts after <startTime>, provided the item following it starts by <endTime>.
+		   The last item that BEGINS in the range is the one just before the first that
+		   starts at or after <endTime>. */
+		
+		q = FirstTimeAtOrAfter(startTime, rawSyncTab, nRawSyncs, True);
+		if (q>0) q--;
+		if (q<nRawSyncs-1 && rawSyncTab[q+1].time<=endTime) *pStart = q;
+		
+		qAfter = FirstTimeAtOrAfter(endTime, rawSyncTab, nRawSyncs, False);
+		if (qAfter>0 && rawSyncTab[qAfter-1].time>=startTime) *pEnd = qAfter;
+		return;
+	}
+	
 	for (q = 0; q<nRawSyncs; q++) {
 		/* Set *pStart to the first item that ENDS in the range. */
 		
@@ -270,7 +314,8 @@ short FitTime(
 			)
 {
 	short quantumN, round=quantum/2, roundN, q, scaledTripBias;
-	long temp, qTime, error, totalError, totalErrorN;
+	long time, error, errorN, totalError, totalErrorN;
+	Boolean leastSquares = config.leastSquares;
 	
 	/* Scale <tripletBias> to cover range of -2*quantum to 2*quantum . */
 	
@@ -280,27 +325,27 @@ short FitTime(
 	   Note that these times are from the beginning of the score, not the measure
 	   or the beat; however, we care only about the error in the closest multiple
 	   of <quantum>, and that will be correct as long as every previous measure has
-	   a duration that's a multiple of <quantum>. */
-	
-	totalError = 0;
-	for (q = start; q<end; q++) {
-		temp = (rawSyncTab[q].time+round)/quantum;
-		qTime = temp*quantum;
-		error = ABS(rawSyncTab[q].time-qTime);
-		totalError += (config.leastSquares? error*error : error);	/* non-tuplet error */
-	}
+	   a duration that's a multiple of <quantum>. We score the normal and the triplet
+	   grid together, in a single pass over the attack times. */
 	
 	quantumN = rangeDur/3;
 	roundN = quantumN/2;
-	totalErrorN = 0;
+	totalError = totalErrorN = 0;
 	for (q = start; q<end; q++) {
-		temp = (rawSyncTab[q].time+roundN)/quantumN;
-		qTime = temp*quantumN;
-		error = ABS(rawSyncTab[q].time-qTime);
-		totalErrorN += (config.leastSquares? error*error : error);	/* triplet error */
+		time = rawSyncTab[q].time;
+		error = ABS(time-((time+round)/quantum)*quantum);			/* non-tuplet error */
+		errorN = ABS(time-((time+roundN)/quantumN)*quantumN);		/* triplet error */
+		if (leastSquares) {
+			totalError += error*error;
+			totalErrorN += errorN*errorN;
+		}
+		else {
+			totalError += error;
+			totalErrorN += errorN;
+		}
 	}
 
-	if (config.leastSquares)
+	if (leastSquares)
 		return (sqrt(totalErrorN-scaledTripBias)<totalError? 3 : 0);
 	else
 		return (totalErrorN-scaledTripBias<totalError? 3 : 0);
@@ -437,6 +482,10 @@ Boolean ChooseAllTuplets(
 	for (k = 0; k<3; k++, shiftDenom /= 10)	
 		tupLevel[k] = (config.tryTupLevels/shiftDenom) % 10;
 	
+	rawTimesSorted = True;
+	for (i = 1; i<nRawSyncs; i++)
+		if (rawSyncTab[i].time<rawSyncTab[i-1].time) { rawTimesSorted = False; break; }
+	
 	/* Decide tuplets for NRCs in one Measure at a time. */
 	
 	for (i = 0; i<measTabLen; i++) {
@@ -452,6 +501,7 @@ Boolean ChooseAllTuplets(
 		}
 	}
 	
+	rawTimesSorted = False;
 	return True;
 }
 
@@ -794,6 +844,8 @@ void QuantizeAndClip(
 	long tupTime, timeSinceTup;				/* Time at last tuplet boundary, time since then */
 	long endTupTime;
 	short tupQuantum, tupRound;				/* Quantum considering the current tuplet */
+	long maxEarlierEnd;						/* >= end time of every NRC before rawSyncTab[q-1] */
+	Boolean scanEarlier;
 		
 	if (quantum==1) return;
 	
@@ -802,8 +854,13 @@ void QuantizeAndClip(
 	tupTime = 0L;
 
 	prevEndTime = 0L;
+	maxEarlierEnd = LONG_MIN;
 	endTuplet = SHRT_MAX;
 	for (q = 0; q<*pnRawSyncs; q++) {
+		if (q>=2) {
+			prevEndTime = rawSyncTab[q-2].time+rawSyncTab[q-2].mult;
+			if (prevEndTime>maxEarlierEnd) maxEarlierEnd = prevEndTime;
+		}
 		
 		/* This may be the end of one tuplet and/or the beginning of another. (Since
 			the NRCs don't cross tuplet boundaries, we can ignore their tupleTimes.) */
@@ -854,9 +911,16 @@ void QuantizeAndClip(
 			or even earlier than them, so the previous ones will end up with zero or
 			negative duration; in that case, they should simply be ignored by subsequent 
 			processing. On the other hand, if it's not yet time for this Sync and we're
-			in a tuplet, to avoid problems with AddTuplets, add a rest to fill the gap. */
+			in a tuplet, to avoid problems with AddTuplets, add a rest to fill the gap.
+			Syncs before rawSyncTab[q-1] can only need truncating, and if <maxEarlierEnd>
+			shows none of them can overlap this one, there's no need to look at them:
+			otherwise, this would take time proportional to the square of the number of
+			Syncs. */
 		
+		scanEarlier = (maxEarlierEnd>rawSyncTab[q].time+PDURUNIT);
+		if (scanEarlier) maxEarlierEnd = LONG_MIN;			/* Recompute it as we go */
 		for (prev = q-1; prev>=0; prev--) {
+			if (prev<q-1 && !scanEarlier) break;
 			prevEndTime = rawSyncTab[prev].time+rawSyncTab[prev].mult;
 			overlapTime = prevEndTime-rawSyncTab[q].time;
 			if (prev==q-1 && overlapTime<=-tupQuantum && tupQuantum!=quantum) {
@@ -875,6 +939,10 @@ void QuantizeAndClip(
 				newMult = rawSyncTab[prev].mult-overlapTime;
 				rawSyncTab[prev].mult = (newMult<=0? 0 : newMult);
 			}
+			if (prev<q-1) {
+				prevEndTime = rawSyncTab[prev].time+rawSyncTab[prev].mult;
+				if (prevEndTime>maxEarlierEnd) maxEarlierEnd = prevEndTime;
+			}
 		}
 	}
 
@@ -444,6 +444,8 @@ static short RfmtSystems(
 	CONTEXT		context;
 	long		timeMove;
 
+	PROF_SCOPE("RfmtSystems");
+
 	measTable = AllocMeasTable(doc,startSysL,endSysL);
 	if (!measTable) {
 		returnCode = FAILURE; goto Cleanup;
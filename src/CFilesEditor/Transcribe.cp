@@ -20,7 +20,8 @@ static short measTabLen=0;
 static MEASINFO *measInfoTab;
 
 static Boolean InitQuantize(Document *, Boolean);
-static short Voice2RTStructs(Document *,short,long,LINKTIMEINFO [],short,short *,NOTEAUX [],short *);
+static void CountAllVoiceNotes(Document *, short [], short []);
+static short AllVoices2RTStructs(Document *,long,LINKTIMEINFO *[],short [],short [],NOTEAUX *[],short []);
 static short Voice2KnownDurs(Document *,short,short,short,LINKTIMEINFO [],short,short,NOTEAUX [],short,
 							long,LINK,LINK,LINK *);
 static LINK QuantAllVoices(Document *, short, short, Boolean);
@@ -67,75 +68,122 @@ static Boolean InitQuantize(Document *doc, Boolean merge)
 	return True;
 }
 
-/* ------------------------------------------------------------------- Voice2RTStructs -- */
+/* ---------------------------------------------------------------- CountAllVoiceNotes -- */
+/* For every voice, count the selected notes in the selection range and the Syncs they're
+in, i.e., the chords, in a single pass: the equivalent of calling VCountNotes twice for
+each voice, which would take two passes over the range per voice. */
+
+static void CountAllVoiceNotes(
+					Document *doc,
+					short nChords[],				/* Output, indexed by voice */
+					short nNotes[] 					/* Output, indexed by voice */
+					)
+{
+	LINK pL, aNoteL, lastSyncL[MAXVOICES+1];
+	short v;
+	
+	for (v = 1; v<=MAXVOICES; v++) {
+		nChords[v] = nNotes[v] = 0;
+		lastSyncL[v] = NILINK;
+	}
+	
+	for (pL = doc->selStartL; pL!=doc->selEndL; pL = RightLINK(pL))
+		if (SyncTYPE(pL)) {
+			for (aNoteL = FirstSubLINK(pL); aNoteL; aNoteL = NextNOTEL(aNoteL)) {
+				v = NoteVOICE(aNoteL);
+				if (v<1 || v>MAXVOICES) continue;
+				nNotes[v]++;
+				if (lastSyncL[v]!=pL) {
+					nChords[v]++;
+					lastSyncL[v] = pL;
+				}
+			}
+		}
+}
+
+
+/* --------------------------------------------------------------- AllVoices2RTStructs -- */
 
 #define DEBUG_NOTE if (DETAIL_SHOW)										\
 						LogPrintf(LOG_DEBUG, "iSync=%d %cvoice=%d [%d] noteNum=%d dur=%ld\n",	\
-						iSync, (nInChord>1? '+' : ' '), voice, nAux,							\
-						rawNoteAux[nAux].noteNumber, rawNoteAux[nAux].duration)
+						iSync[v], (nInChord[v]>1? '+' : ' '), v, nAux[v],						\
+						rawNoteAux[v][nAux[v]].noteNumber, rawNoteAux[v][nAux[v]].duration)
 
 
-static short Voice2RTStructs(
+/* Fill in the rawSyncTab[] and rawNoteAux[] for every voice that has them (i.e., that has
+non-NULL tables) from the selected notes in the selection range. The voices are all done
+in a single pass over the range. Returns FAILURE if any voice's table overflows, else
+OP_COMPLETE if any voice has notes, else NOTHING_TO_DO. */
+
+static short AllVoices2RTStructs(
 					Document *doc,
-					short voice,
 					long startTime,
-					LINKTIMEINFO rawSyncTab[],		/* Output: raw (unquantized and unclarified) NCs */
-					short maxRawSyncs,				/* Maximum size of rawSyncTab */
-					short *pnSyncs,
-					NOTEAUX rawNoteAux[],			/* Output: auxiliary info on raw notes */
-					short *pnAux
+					LINKTIMEINFO *rawSyncTab[],		/* Output, per voice: raw (unquantized and unclarified) NCs */
+					short maxRawSyncs[],			/* Maximum size of each rawSyncTab */
+					short nSyncs[],					/* Output: size of each rawSyncTab */
+					NOTEAUX *rawNoteAux[],			/* Output, per voice: auxiliary info on raw notes */
+					short nAux[]					/* Output: size of each rawNoteAux */
 					)
 {
 	long prevStartTime, chordEndTime;
-	short iSync, nAux, nInChord;
-	LINK pL, aNoteL;  PANOTE aNote;
+	short v, iSync[MAXVOICES+1], nInChord[MAXVOICES+1];
+	LINK pL, aNoteL, lastSyncL[MAXVOICES+1];  PANOTE aNote;
+	Boolean anyNotes;
 	
-	prevStartTime = -999999L;
-	iSync = -1;
-	nAux = -1;
+	for (v = 1; v<=MAXVOICES; v++) {
+		iSync[v] = -1;
+		nAux[v] = -1;
+		nInChord[v] = 0;
+		lastSyncL[v] = NILINK;
+	}
 	
 	for (pL = doc->selStartL; pL!=doc->selEndL; pL = RightLINK(pL)) {
 		switch (ObjLType(pL)) {
 			case SYNCtype:
-				if (LinkSEL(pL) && SyncInVoice(pL, voice)) {
-					nInChord = 0;
-					for (aNoteL = FirstSubLINK(pL); aNoteL; aNoteL = NextNOTEL(aNoteL))
-						if (NoteSEL(aNoteL) && NoteVOICE(aNoteL)==voice) {
-							nInChord++;
-							nAux++;
-							if (nInChord==1) {
-								iSync++;
-								if (iSync>=maxRawSyncs) {
-									MayErrMsg("Voice2RTStructs: maxRawSyncs exceeded.");
-									return FAILURE;
-								}
-								rawSyncTab[iSync].link = nAux;
-							}
-		
-							aNote = GetPANOTE(aNoteL);
-							rawNoteAux[nAux].noteNumber = aNote->noteNum;
-							rawNoteAux[nAux].onVelocity =  aNote->onVelocity;
-							rawNoteAux[nAux].offVelocity =  aNote->offVelocity;
-							rawNoteAux[nAux].duration =  aNote->playDur;
-							rawNoteAux[nAux].first = (nInChord==1);
-							DEBUG_NOTE;
-	
-							prevStartTime = SyncAbsTime(pL)-startTime;
-			
-							/* If this note is part of a chord, use the latest end time. */
-							
-							if (nInChord>1) {
-								chordEndTime = prevStartTime+rawSyncTab[iSync].mult;
-								if (prevStartTime+rawNoteAux[nAux].duration>chordEndTime) {
-									rawSyncTab[iSync].mult = rawNoteAux[nAux].duration;
-								}
-		
-							}
-							else {
-								rawSyncTab[iSync].mult = rawNoteAux[nAux].duration;
-								rawSyncTab[iSync].time = SyncAbsTime(pL)-startTime;
-							}			
+				if (!LinkSEL(pL)) break;
+				for (aNoteL = FirstSubLINK(pL); aNoteL; aNoteL = NextNOTEL(aNoteL)) {
+					if (!NoteSEL(aNoteL)) continue;
+					v = NoteVOICE(aNoteL);
+					if (v<1 || v>MAXVOICES || !rawSyncTab[v]) continue;
+					
+					if (lastSyncL[v]!=pL) {
+						nInChord[v] = 0;
+						lastSyncL[v] = pL;
+					}
+					nInChord[v]++;
+					nAux[v]++;
+					if (nInChord[v]==1) {
+						iSync[v]++;
+						if (iSync[v]>=maxRawSyncs[v]) {
+							MayErrMsg("AllVoices2RTStructs: maxRawSyncs exceeded for voice %ld.",
+										(long)v);
+							return FAILURE;
+						}
+						rawSyncTab[v][iSync[v]].link = nAux[v];
+					}
+
+					aNote = GetPANOTE(aNoteL);
+					rawNoteAux[v][nAux[v]].noteNumber = aNote->noteNum;
+					rawNoteAux[v][nAux[v]].onVelocity =  aNote->onVelocity;
+					rawNoteAux[v][nAux[v]].offVelocity =  aNote->offVelocity;
+					rawNoteAux[v][nAux[v]].duration =  aNote->playDur;
+					rawNoteAux[v][nAux[v]].first = (nInChord[v]==1);
+					DEBUG_NOTE;
+
+					prevStartTime = SyncAbsTime(pL)-startTime;
+	
+					/* If this note is part of a chord, use the latest end time. */
+					
+					if (nInChord[v]>1) {
+						chordEndTime = prevStartTime+rawSyncTab[v][iSync[v]].mult;
+						if (prevStartTime+rawNoteAux[v][nAux[v]].duration>chordEndTime) {
+							rawSyncTab[v][iSync[v]].mult = rawNoteAux[v][nAux[v]].duration;
 						}
+					}
+					else {
+						rawSyncTab[v][iSync[v]].mult = rawNoteAux[v][nAux[v]].duration;
+						rawSyncTab[v][iSync[v]].time = prevStartTime;
+					}			
 				}
 				break;
 
@@ -144,11 +192,18 @@ static short Voice2RTStructs(
 		}
 	}
 
-	rawNoteAux[++nAux].first = True;											/* Sentinel at end */
+	anyNotes = False;
+	for (v = 1; v<=MAXVOICES; v++) {
+		if (!rawSyncTab[v]) {
+			nSyncs[v] = nAux[v] = 0;
+			continue;
+		}
+		rawNoteAux[v][++nAux[v]].first = True;									/* Sentinel at end */
+		nSyncs[v] = iSync[v]+1;
+		if (iSync[v]>=0) anyNotes = True;
+	}
 
-	*pnSyncs = iSync+1;
-	*pnAux = nAux;
-	return (iSync>=0? OP_COMPLETE : NOTHING_TO_DO);
+	return (anyNotes? OP_COMPLETE : NOTHING_TO_DO);
 }
 
 /* ------------------------------------------------------------------- Voice2KnownDurs -- */
@@ -444,6 +499,7 @@ static LINK QuantAllVoices(
 	LINKTIMEINFO *rawSyncTab[MAXVOICES+1];		/* Arrays of pointers to tables */
 	NOTEAUX	*rawNoteAux[MAXVOICES+1];
 	short maxSyncs[MAXVOICES+1], nRawSyncs[MAXVOICES+1], nAux[MAXVOICES+1];
+	short nChordsInV[MAXVOICES+1], nNotesInV[MAXVOICES+1];
 	LINK prevMeasL, endExtraL, qStartL, qEndL;
 	LINK lastL=NILINK;
 	
@@ -463,11 +519,15 @@ static LINK QuantAllVoices(
 	prevMeasL = SSearch(doc->selStartL, MEASUREtype, GO_LEFT);
 	startTime = MeasureTIME(prevMeasL)-timeOffset;
 	
-	/* Make a rawSyncTab[] and a rawNoteAux[] for each voice in the range. */
+	/* Make a rawSyncTab[] and a rawNoteAux[] for each voice in the range. The voices
+	   are independent of each other until we merge them back in, so we count the notes
+	   and then fill in the tables for all of them in one pass over the range each,
+	   rather than two passes for every voice. */
 	
+	CountAllVoiceNotes(doc, nChordsInV, nNotesInV);
 	for (v = 1; v<=MAXVOICES; v++) {
 		if (VOICE_MAYBE_USED(doc, v)) {
-			nSyncs = VCountNotes(v, doc->selStartL, doc->selEndL, True);
+			nSyncs = nChordsInV[v];
 			
 			/* If nothing in voice in range, set variables to safe values. */
 			
@@ -478,7 +538,7 @@ static LINK QuantAllVoices(
 				continue;
 			}
 			maxSyncs[v] = 2*nSyncs+EXTRA_OBJS;
-			nNotes = VCountNotes(v, doc->selStartL, doc->selEndL, False);
+			nNotes = nNotesInV[v];
 	
 			len = maxSyncs[v]*sizeof(LINKTIMEINFO);
 			rawSyncTab[v] = (LINKTIMEINFO *)NewPtr(len);
@@ -494,14 +554,14 @@ static LINK QuantAllVoices(
 				OutOfMemory(len);
 				goto Done;
 			}
-	
-			status = Voice2RTStructs(doc, v, startTime, rawSyncTab[v], maxSyncs[v],
-											&nRawSyncs[v], rawNoteAux[v], &nAux[v]);
-			if (status==FAILURE) goto Done;
 		}
 		else
 			nRawSyncs[v] = nAux[v] = 0;
 	}
+
+	status = AllVoices2RTStructs(doc, startTime, rawSyncTab, maxSyncs, nRawSyncs,
+									rawNoteAux, nAux);
+	if (status==FAILURE) goto Done;
 	
 	InitQuantize(doc, merge);
 	
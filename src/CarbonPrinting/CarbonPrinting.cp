@@ -38,6 +38,8 @@ static OSStatus PrintPostScript(Document *doc, UInt32 firstSheet, UInt32 lastShe
 static OSStatus DocFormatGetAdjustedPaperRect(Document *doc, Rect *paperRect, Boolean xlateScale);
 static OSStatus NDocDrawPage(Document *doc, UInt32 pageNum);
 static Boolean DocSessionOK(Document *doc, OSStatus status);
+static void ExportDefaultName(Document *doc, const char *suffix, Str255 name);
+static Boolean ExportPathName(FSSpec *pFSSpec, const char *suffix, char *pathName);
 static void DocReleasePrintSession(Document *doc);
 static void DocReleasePageFormat(Document *doc);
 static void DocReleasePrintSettings(Document *doc);
@@ -1151,6 +1153,264 @@ Boolean DoPostScript(Document *doc)
 	}
 
 
+/* -------------------------------------------------------------------- ExportPagesBMP -- */
+/* Render pages [firstSheet, lastSheet] of the score offscreen at 100% and write each one
+as a black-and-white BMP file named <baseName>_<page number>.bmp. This needs no window or
+printer, so it's suitable for making previews or thumbnails in batches. All pages share
+one offscreen GWorld. Returns the number of pages written. */
+
+short ExportPagesBMP(Document *doc, char *baseName, short firstSheet, short lastSheet)
+{
+	short			saveOutputTo, saveMagnify, saveSheet, sheet, width, height, nDone=0;
+	Rect			paperRect, saveCurrPaper, portRect;
+	GWorldPtr		gWorld;
+	CGrafPtr		origPort;
+	GDHandle		origDev;
+	PixMapHandle	pixMapH;
+	QDErr			err;
+	char			filename[PATH_MAX];
+	
+	if (firstSheet<0) firstSheet = 0;
+	if (lastSheet>=doc->numSheets) lastSheet = doc->numSheets-1;
+	
+	paperRect = doc->origPaperRect;
+	width = paperRect.right-paperRect.left;
+	height = paperRect.bottom-paperRect.top;
+	SetRect(&portRect, 0, 0, width, height);
+	
+	err = NewGWorld(&gWorld, 1, &portRect, NULL, NULL, 0);		/* 1 bit deep */
+	if (gWorld==NULL || err!=noErr) {
+		LogPrintf(LOG_ERR, "Couldn't create GWorld of width %d and height %d.  (ExportPagesBMP)\n",
+					width, height);
+		NoMoreMemory();
+		return 0;
+	}
+	pixMapH = GetGWorldPixMap(gWorld);
+	if (!LockPixels(pixMapH)) {
+		DisposeGWorld(gWorld);
+		NoMoreMemory();
+		return 0;
+	}
+	
+	GetGWorld(&origPort, &origDev);
+	SetGWorld(gWorld, NULL);
+	
+	saveOutputTo = outputTo;							/* Save state */
+	saveMagnify = doc->magnify;
+	saveSheet = doc->currentSheet;
+	saveCurrPaper = doc->currentPaper;
+	outputTo = toBitmapPrint;
+	doc->magnify = 0;
+	InstallMagnify(doc);
+	WaitCursor();
+	
+	for (sheet = firstSheet; sheet<=lastSheet; sheet++) {
+		EraseRect(&portRect);
+		ClipRect(&portRect);
+		DrawPageContent(doc, sheet, &paperRect, &paperRect);
+
+		snprintf(filename, PATH_MAX, "%s_%d.bmp", baseName, sheet+doc->firstPageNumber);
+		if (!NWriteBMPFile(filename, (Byte *)GetPixBaseAddr(pixMapH),
+								(long)(GetPixRowBytes(pixMapH) & 0x3FFF), width, height))
+			break;
+		nDone++;
+	}
+	
+	outputTo = saveOutputTo;							/* Restore state */
+	doc->magnify = saveMagnify;
+	InstallMagnify(doc);
+	doc->currentSheet = saveSheet;
+	doc->currentPaper = saveCurrPaper;
+
+	SetGWorld(origPort, origDev);
+	UnlockPixels(pixMapH);
+	DisposeGWorld(gWorld);
+	ArrowCursor();
+	
+	LogPrintf(LOG_INFO, "Wrote %d page image(s) to '%s_*.bmp'.  (ExportPagesBMP)\n",
+				nDone, baseName);
+	return nDone;
+}
+
+
+/* ---------------------------------------------------------------- DoExportPageImages -- */
+/* Handle the Export Page Images command: ask the user for a base file name and write
+every page of the score as a BMP file whose name is that plus the page number. */
+
+Boolean DoExportPageImages(Document *doc)
+{
+	Str255			outname;
+	short			vref, nDone;
+	NSClientData	nscd;
+	FSSpec			fsSpec;
+	char			baseName[PATH_MAX];
+	
+	ExportDefaultName(doc, "", outname);
+	if (!GetOutputName(MiscStringsID, 9, outname, &vref, &nscd)) return False;
+	
+	fsSpec = nscd.nsFSSpec;
+	if (!ExportPathName(&fsSpec, ".bmp", baseName)) {
+		CParamText("Can't find the folder to put the page images in.", "", "", "");	// ??I18N BUG
+		StopInform(GENERIC_ALRT);
+		return False;
+	}
+	
+	nDone = ExportPagesBMP(doc, baseName, 0, doc->numSheets-1);
+	if (nDone<doc->numSheets) {
+		CParamText("Couldn't write all the page images. See the log for details.", "", "", "");	// ??I18N BUG
+		StopInform(GENERIC_ALRT);
+		return False;
+	}
+	return True;
+}
+
+
+/* Put into <name> a default name for a file exported from <doc>: the score's name, or
+"Untitled", truncated if need be so that adding <suffix> doesn't make it too long. */
+
+static void ExportDefaultName(Document *doc, const char *suffix, Str255 name)
+{
+	short len, suffixLen;
+	
+	if (doc->named)	Pstrcpy(name, doc->name);
+	else			GetIndString(name, MiscStringsID, 1);		/* "Untitled" */
+	
+	suffixLen = strlen(suffix);
+	len = name[0];
+	if (len>FILENAME_MAXLEN-suffixLen) len = FILENAME_MAXLEN-suffixLen;
+	BlockMove(suffix, &name[len+1], suffixLen);
+	name[0] = len+suffixLen;
+}
+
+
+/* Put into <pathName>, which must have room for PATH_MAX chars, the full POSIX path of
+the file <*pFSSpec>, which needn't exist yet, less <suffix> if its name ends with that.
+Return True if all went well. */
+
+static Boolean ExportPathName(FSSpec *pFSSpec, const char *suffix, char *pathName)
+{
+	FSSpec	dirSpec;
+	FSRef	dirRef;
+	char	fileName[256];
+	long	len, suffixLen;
+	
+	if (FSMakeFSSpec(pFSSpec->vRefNum, pFSSpec->parID, "\p", &dirSpec)!=noErr) return False;
+	if (FSpMakeFSRef(&dirSpec, &dirRef)!=noErr) return False;
+	if (FSRefMakePath(&dirRef, (UInt8 *)pathName, PATH_MAX)!=noErr) return False;
+	
+	Pstrcpy((StringPtr)fileName, pFSSpec->name);
+	PToCString((StringPtr)fileName);
+	len = strlen(fileName);
+	suffixLen = strlen(suffix);
+	if (suffixLen>0 && len>suffixLen && strcasecmp(fileName+len-suffixLen, suffix)==0)
+		fileName[len-suffixLen] = '\0';
+	
+	if (strlen(pathName)+1+strlen(fileName)>=PATH_MAX) return False;
+	strcat(pathName, "/");
+	strcat(pathName, fileName);
+	return True;
+}
+
+
+/* --------------------------------------------------------------------- ExportPagesPDF -- */
+/* Write pages [firstSheet, lastSheet] of the score directly to a PDF file at <pathName>,
+without going through PostScript and a separate distilling step. We draw exactly as for
+bitmap printing, but send the print job to a file in PDF format; the printing system turns
+our QuickDraw into PDF vector graphics, embedding just the subsets of fonts (including
+the music font) that are used, and compressing the content streams. Returns noErr or a
+Printing Manager error code. */
+
+OSStatus ExportPagesPDF(Document *doc, char *pathName, short firstSheet, short lastSheet)
+{
+	OSStatus		status;
+	PMPrintSettings	printSettings = kPMNoPrintSettings;
+	CFURLRef		pdfURL = NULL;
+	short			saveOutputTo, saveMagnify;
+	
+	if (firstSheet<0) firstSheet = 0;
+	if (lastSheet>=doc->numSheets) lastSheet = doc->numSheets-1;
+
+	status = DocSetupPageFormat(doc);
+	if (status != noErr) return status;
+	
+	status = PMCreatePrintSettings(&printSettings);
+	if (status == noErr && printSettings == kPMNoPrintSettings) status = kPMGeneralError;
+	if (status == noErr)
+		status = PMSessionDefaultPrintSettings(doc->docPrintInfo.docPrintSession, printSettings);
+	
+	if (status == noErr) {
+		pdfURL = CFURLCreateFromFileSystemRepresentation(NULL, (UInt8 *)pathName,
+															strlen(pathName), False);
+		if (pdfURL == NULL) status = kPMGeneralError;
+	}
+	if (status == noErr)
+		status = PMSessionSetDestination(doc->docPrintInfo.docPrintSession, printSettings,
+											kPMDestinationFile, kPMDocumentFormatPDF, pdfURL);
+
+	if (status == noErr) {
+		doc->docPrintInfo.docPrintSettings = printSettings;
+		printSettings = kPMNoPrintSettings;
+
+		saveOutputTo = outputTo;						/* Save state */
+		saveMagnify = doc->magnify;
+		outputTo = toBitmapPrint;
+		doc->magnify = 0;
+		InstallMagnify(doc);
+		WaitCursor();
+
+		status = PrintBitmap(doc, firstSheet, lastSheet);
+
+		outputTo = saveOutputTo;						/* Restore state */
+		doc->magnify = saveMagnify;
+		InstallMagnify(doc);
+		ArrowCursor();
+	}
+
+	if (pdfURL != NULL) CFRelease(pdfURL);
+	if (printSettings != kPMNoPrintSettings) PMRelease(printSettings);
+	DocReleasePrintSettings(doc);
+	DocReleasePrintSession(doc);
+
+	if (status == noErr)
+		LogPrintf(LOG_INFO, "Wrote page(s) %d thru %d to PDF file '%s'.  (ExportPagesPDF)\n",
+					firstSheet+doc->firstPageNumber, lastSheet+doc->firstPageNumber, pathName);
+	else
+		LogPrintf(LOG_ERR, "Couldn't write PDF file '%s': error %ld.  (ExportPagesPDF)\n",
+					pathName, (long)status);
+	return status;
+}
+
+
+/* ----------------------------------------------------------------------- DoExportPDF -- */
+/* Handle the Export PDF command: ask the user for a file name and write every page of
+the score to it as PDF. */
+
+Boolean DoExportPDF(Document *doc)
+{
+	Str255			outname;
+	short			vref;
+	NSClientData	nscd;
+	FSSpec			fsSpec;
+	char			pathName[PATH_MAX];
+	
+	ExportDefaultName(doc, ".pdf", outname);
+	if (!GetOutputName(MiscStringsID, 9, outname, &vref, &nscd)) return False;
+	
+	fsSpec = nscd.nsFSSpec;
+	if (!ExportPathName(&fsSpec, "", pathName)) {
+		CParamText("Can't find the folder to put the PDF file in.", "", "", "");	// ??I18N BUG
+		StopInform(GENERIC_ALRT);
+		return False;
+	}
+	
+	if (ExportPagesPDF(doc, pathName, 0, doc->numSheets-1)!=noErr) {
+		CParamText("Couldn't write the PDF file. See the log for details.", "", "", "");	// ??I18N BUG
+		StopInform(GENERIC_ALRT);
+		return False;
+	}
+	return True;
+}
+
 enum {
 	BUT1_OK = 1,
 	BUT2_Cancel,
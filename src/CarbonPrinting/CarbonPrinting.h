@@ -63,5 +63,9 @@ OSStatus FlattenAndSavePageFormat(Document *doc);
 OSStatus	LoadAndUnflattenPageFormat(Document *doc);
 
 Boolean DoPostScript(Document *doc);
+short ExportPagesBMP(Document *doc, char *baseName, short firstSheet, short lastSheet);
+Boolean DoExportPageImages(Document *doc);
+OSStatus ExportPagesPDF(Document *doc, char *pathName, short firstSheet, short lastSheet);
+Boolean DoExportPDF(Document *doc);
 
 #endif	// __MyCarbonPrinting__
@@ -146,6 +146,23 @@ Boolean AddToResultList(
 }
 
 
+/* The matches in the result list refer to their scores by LINK, so if something
+renumbers a score's LINKs, as CompactHeaps does, its matches can't be shown any more.
+Mark them so ShowMatch says so instead of selecting the wrong objects. */
+
+void ForgetResultListMatches(Document *doc)
+{
+	extern Document *documentTable;			/* Ptr to head of score table */
+	INT16 i, docNum;
+	
+	if (!docNumA) return;
+	
+	docNum = doc-documentTable;
+	for (i = 0; i<itemCount; i++)
+		if (docNumA[i]==docNum) docNumA[i] = -1;
+}
+
+
 /* -------------------------------------------------------------------------------------- */
 /* GetCtlHandle - Just a handy way to get a control's handle given only the item number
 and the dialog. */
@@ -261,6 +278,12 @@ Boolean ShowMatch(INT16 matchNum)
 	Document		*doc;
 	long			offset;
 
+	if (docNumA[matchNum]<0) {
+		CParamText("Can't show that match: the score has been reorganized since the search. Please search again.", "",
+						"", "");								// ??I18N BUG AND NOT USER-FRIENDLY
+		StopInform(GENERIC_ALRT);
+		return False;
+	}
 	doc = documentTable+docNumA[matchNum];
 	if (!doc->inUse) {
 		CParamText("Can't show that match: the score is no longer open.", "",
@@ -325,6 +325,7 @@ Boolean InitResultList(INT16 maxItems, INT16 patLen);
 Boolean AddToResultList(char str[], MATCHINFO matchInfo, DB_LINK matchedObjA[MAX_PATLEN],
 						DB_LINK matchedSubobjA[MAX_PATLEN]);
 Boolean DoResultList(char label[]);
+void ForgetResultListMatches(Document *doc);
 
 Boolean BuildDocList(Document *doc, short fontSize);
 Boolean HandleResultListUpdate(void);
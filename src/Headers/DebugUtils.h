@@ -17,6 +17,7 @@
 
 extern short nerr, errLim;
 extern Boolean minDebugCheck;			/* True=don't print Less & Least important checks */
+extern Boolean dcheckHeadless;			/* True=checking with no user interface */
 
 #ifdef DDB
 
@@ -254,6 +254,8 @@ enum {							/* File menu */
 	FM_PageSetup,
 	FM_Print,
 	FM_SavePostScript,
+	FM_ExportPDF,					/* Not in the MENU resource: added by InitGlobals */
+	FM_ExportPageImages,			/* Not in the MENU resource: added by InitGlobals */
 	FM_SaveText,
 	FM_____________3,
 	FM_ScoreInfo,
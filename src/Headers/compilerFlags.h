@@ -19,4 +19,6 @@ Relationships among versions:
 
 #define USE_GWORLDS	/* instead of 1-bit GrafPorts for dragging and a few other things */
 
+#define NoPROFILE_HOOKS	/* PROFILE_HOOKS = time hot paths with PROF_SCOPE, etc. (see Debug.h) */
+
 //#define USE_NL2XML
@@ -38,6 +38,20 @@ const int kActiveSensingLen 	= 1;
 const int kNoteOnLen 			= 3;
 const int kNoteOffLen 			= 3;
 
+// Incoming MIDI goes from the Core MIDI read proc (on Core MIDI's own thread) into a
+// single-producer/single-consumer ring of fixed-size records; the main thread drains
+// the ring into gMIDIPacketList. Only the read proc advances gCMRingHead, and only
+// the main thread advances gCMRingTail, so no locking is needed.
+
+const int kCMEventMaxLen		= 3;				// Longest message we accept (Note On/Off)
+const long kCMRingLen			= 0x1000;			// 4096; must be a power of 2
+
+typedef struct {
+	MIDITimeStamp	timeStamp;
+	UInt16			length;
+	Byte			data[kCMEventMaxLen];
+} CMInputEvent;
+
 CORE_MIDIGLOBAL Byte			gMIDIPacketListBuf[kCMBufLen];
 CORE_MIDIGLOBAL Byte			gMIDIWritePacketListBuf[kCMWriteBufLen];
 
@@ -57,6 +71,12 @@ CORE_MIDIGLOBAL Boolean			appOwnsBITimer;
 CORE_MIDIGLOBAL long			gCMBufferLength;	// CM MIDI Buffer size in bytes
 CORE_MIDIGLOBAL Boolean			gCMMIDIBufferFull;
 
+CORE_MIDIGLOBAL CMInputEvent	gCMInputRing[kCMRingLen];
+CORE_MIDIGLOBAL volatile long	gCMRingHead;		// Next slot to fill; read proc only
+CORE_MIDIGLOBAL volatile long	gCMRingTail;		// Next slot to drain; main thread only
+CORE_MIDIGLOBAL volatile long	gCMRingDropped;		// Events lost because the ring was full
+CORE_MIDIGLOBAL long			gCMRingHighWater;	// Max. no. of events ever waiting in ring
+
 CORE_MIDIGLOBAL MIDIUniqueID	gSelectedInputDevice;
 CORE_MIDIGLOBAL int				gSelectedInputChannel;
 CORE_MIDIGLOBAL MIDIUniqueID	gSelectedThruDevice;
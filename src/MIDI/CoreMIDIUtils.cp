@@ -11,6 +11,8 @@
 
 #include "NTimeMgr.h"
 
+#include <libkern/OSAtomic.h>
+
 #define _CORE_MIDIGLOBALS_
 
 #include "CoreMidiDefs.h"
@@ -52,31 +54,84 @@ static Boolean CMAcceptPacket(MIDIPacket *pkt)
 	return False;
 }
 
+/* Called by Core MIDI on its own thread. We can't safely touch <gMIDIPacketList> here,
+since the main thread may be reading it; instead, just copy the packets we want into
+the input ring for DrainCMInputRing to pick up. If the ring is full, drop the packet
+and count it. */
+
 static void	NightCMReadProc(const MIDIPacketList *pktlist, void * /* refCon */, void * /* connRefCon */);
 static void	NightCMReadProc(const MIDIPacketList *pktlist, void * /* refCon */, void * /* connRefCon */)
 {
-//	if (CMEndOfBuffer()) return;
-		
-	MIDIPacket *packetToAdd = gCurrPktListEnd;
-	
+	long head, nWaiting;
+	CMInputEvent *pEvent;
+
 	if (gOutPort != NULL && gDest != NULL) {
 		MIDIPacket *packet = (MIDIPacket *)pktlist->packet;	// remove const (!)
 		unsigned int j = 0;
-		for ( ; j < pktlist->numPackets && !CMEndOfBuffer(MIDIPacketNext(packetToAdd),
-				packet->length); j++) {
+		for ( ; j < pktlist->numPackets; j++) {
 		
 			/* Take only packets that are acceptable to us. For example, active sensing is
 			   sent once every 300 milliseconds. */
 			
-			if (CMAcceptPacket(packet)) {
-				packetToAdd = MIDIPacketListAdd(gMIDIPacketList, sizeof(gMIDIPacketListBuf),
-								packetToAdd, packet->timeStamp, packet->length, packet->data);
+			if (CMAcceptPacket(packet) && packet->length<=kCMEventMaxLen) {
+				head = gCMRingHead;
+				nWaiting = head-gCMRingTail;
+				if (nWaiting>=kCMRingLen) {
+					gCMRingDropped++;
+				}
+				else {
+					pEvent = &gCMInputRing[head & (kCMRingLen-1)];
+					pEvent->timeStamp = packet->timeStamp;
+					pEvent->length = packet->length;
+					BlockMoveData(packet->data, pEvent->data, packet->length);
+					
+					/* Make sure the event is complete before the consumer can see it. */
+					
+					OSMemoryBarrier();
+					gCMRingHead = head+1;
+					if (nWaiting+1>gCMRingHighWater) gCMRingHighWater = nWaiting+1;
+				}
 			}
 			packet = MIDIPacketNext(packet);
 		}
 	}
+}
+
+
+/* ------------------------------------------------------------------ DrainCMInputRing -- */
+/* Move all events waiting in the input ring into <gMIDIPacketList>. Must be called
+only from the main thread. If <gMIDIPacketList> fills up, set <gCMMIDIBufferFull> and
+leave the remaining events in the ring. Returns the number of events moved. */
+
+long DrainCMInputRing()
+{
+	long tail, head, nDrained = 0L;
+	CMInputEvent *pEvent;
+	MIDIPacket *packetToAdd;
+	
+	if (gMIDIPacketList == NULL) return 0L;
+	
+	head = gCMRingHead;
+	OSMemoryBarrier();									/* Don't read events before <head> */
+	for (tail = gCMRingTail; tail!=head; tail++) {
+		pEvent = &gCMInputRing[tail & (kCMRingLen-1)];
+		if (CMEndOfBuffer(MIDIPacketNext(gCurrPktListEnd), pEvent->length)) {
+			gCMMIDIBufferFull = True;
+			break;
+		}
+		packetToAdd = MIDIPacketListAdd(gMIDIPacketList, sizeof(gMIDIPacketListBuf),
+							gCurrPktListEnd, pEvent->timeStamp, pEvent->length, pEvent->data);
+		if (packetToAdd == NULL) {
+			gCMMIDIBufferFull = True;
+			break;
+		}
+		gCurrPktListEnd = packetToAdd;
+		nDrained++;
+	}
 	
-	gCurrPktListEnd = packetToAdd;
+	OSMemoryBarrier();									/* Done with the slots before freeing them */
+	gCMRingTail = tail;
+	return nDrained;
 }
 
 
@@ -90,6 +145,9 @@ static Boolean AllocCMPacketList(void)
 {
 	gMIDIPacketList = (MIDIPacketList *)gMIDIPacketListBuf;
 	gCurrentPacket = gCurrPktListBegin = gCurrPktListEnd = MIDIPacketListInit(gMIDIPacketList);
+	gCMRingTail = gCMRingHead;
+	gCMRingDropped = gCMRingHighWater = 0L;
+	gCMMIDIBufferFull = False;
 	
 	return (gCurrentPacket != NULL);
 }
@@ -102,6 +160,9 @@ Boolean ResetMIDIPacketList()
 {
 	gMIDIPacketList = (MIDIPacketList *)gMIDIPacketListBuf;
 	gCurrentPacket = gCurrPktListBegin = gCurrPktListEnd = MIDIPacketListInit(gMIDIPacketList);
+	gCMRingTail = gCMRingHead;								/* Discard anything left over */
+	gCMRingDropped = gCMRingHighWater = 0L;
+	gCMMIDIBufferFull = False;
 	
 	return (gCurrentPacket != NULL);
 }
@@ -114,6 +175,7 @@ Boolean CMCurrentPacketValid()
 
 void SetCMMIDIPacket()
 {
+	DrainCMInputRing();
 	gCurrentPacket = gCurrPktListBegin;
 }
 
@@ -130,6 +192,7 @@ MIDIPacket *GetCMMIDIPacket(void)
 {
 	MIDIPacket *pmPkt = NULL;
 	
+	DrainCMInputRing();
 	if (CMCurrentPacketValid()) {
 		pmPkt = gCurrentPacket;
 		gCurrentPacket = MIDIPacketNext(gCurrentPacket);
@@ -264,6 +327,9 @@ void CMNormalizeTimeStamps()
 
 void CloseCoreMidiInput(void)
 {
+	DrainCMInputRing();
+	LogPrintf(LOG_INFO, "Input ring high-water mark=%ld of %ld, dropped=%ld, packet list %s.  (CloseCoreMidiInput)\n",
+				gCMRingHighWater, kCMRingLen, gCMRingDropped, (gCMMIDIBufferFull? "FULL" : "OK"));
 	gCurrPktListEnd = AddActiveSensingPacket(gCurrPktListEnd);
 }
 
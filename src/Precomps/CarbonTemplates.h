@@ -10,6 +10,7 @@ using namespace std;
 #define CMPKT_HDR_SIZE			6
 
 Boolean ResetMIDIPacketList();
+long DrainCMInputRing(void);
 void SetCMMIDIPacket(void);
 void ClearCMMIDIPacket(void);
 MIDIPacket *GetCMMIDIPacket(void);
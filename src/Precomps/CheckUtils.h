@@ -17,6 +17,7 @@ Rect SetSubRect(DDIST, DDIST, short, PCONTEXT);
 void ContextObject(Document *, LINK, CONTEXT []);
 LINK CheckObject (Document *, LINK, Boolean *, Ptr, CONTEXT [], short, short *, STFRANGE);
 Boolean ObjectTest(Rect *, Point, LINK);
+void InvalHitIndex(void);
 LINK FindAndActOnObject(Document *, Point, short *, short);
 
 LINK FindRelObject(Document *, Point, short *, short);
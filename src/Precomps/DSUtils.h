@@ -10,6 +10,10 @@ void InvalRange(LINK, LINK);
 void EraseAndInvalRange(Document *, LINK, LINK);
 void InvalRangeContent(LINK, LINK);
 void InvalObject(Document *doc, LINK pL, short doErase);
+void BeginInvalBatch(void);
+void EndInvalBatch(void);
+void FlushInvalBatch(void);
+void GetInvalBatchStats(long *pnRects, long *pnRedundant, long *pnFlushes);
 
 void FixMeasNums(LINK, short);
 Boolean IsFakeMeasure(Document *, LINK);
@@ -2,7 +2,26 @@
 
 enum { MAIN_DSTR, CLIP_DSTR, UNDO_DSTR, MP_DSTR };
 
+/* What DCheckEverythingResults found: the no. of problems reported by each check, in
+the order the checks were run. */
+
+#define MAX_DCHECK_PASSES 28
+
+typedef struct {
+	const char	*name;				/* Name of the check routine */
+	short		nErrors;			/* No. of problems it reported */
+} DCHECKPASS;
+
+typedef struct {
+	Boolean		fatal;				/* Too damaged to finish checking? */
+	short		nObjs;				/* No. of objects in the main object list */
+	short		nErrors;			/* Total no. of problems reported */
+	short		nPasses;			/* No. of entries in pass[] */
+	DCHECKPASS	pass[MAX_DCHECK_PASSES];
+} DCHECKRESULTS;
+
 Boolean DCheckEverything(Document *, Boolean, Boolean);
+Boolean DCheckEverythingResults(Document *, Boolean, DCHECKRESULTS *);
 short DCheckNode(Document *, LINK, short, Boolean);
 
 /* DebugUtils.c */
@@ -65,6 +84,41 @@ void DSubobjDump(short iHp, unsigned char *pLink1, short nFrom, short nTo, Boole
 void DObjDump(char *label, short nFrom, short nTo);
 void DPrintRow(Byte bitmap[], short startLoc, short byWidth, short rowNum, Boolean foreIsAOne,
 				Boolean skipBits);
+long ProfBegin(const char *name, long arg);
+void ProfEnd(long event);
+void ProfReset(void);
+void ProfLogSummary(void);
+Boolean ProfWriteTrace(char *pathName);
+
+/* Profiling hooks. If PROFILE_HOOKS is #defined (in compilerFlags.h), PROF_SCOPE times
+from where it appears to the end of the enclosing block, and PROF_BEGIN/PROF_END time an
+explicit stretch of code; the timings go into a ring buffer that ProfLogSummary and
+ProfWriteTrace report on. Otherwise the macros generate no code at all. <name> must be
+a string constant: only the pointer is kept. */
+
+#define PROF_TRACE_FILE "/tmp/NightingaleTrace.json"	/* Where the Test menu writes traces */
+
+#ifdef PROFILE_HOOKS
+
+typedef struct PROFSCOPE {
+	long	event;
+	PROFSCOPE(const char *name, long arg) { event = ProfBegin(name, arg); }
+	~PROFSCOPE() { ProfEnd(event); }
+} PROFSCOPE;
+
+#define PROF_SCOPE(name)				PROFSCOPE profScope(name, 0L)
+#define PROF_SCOPE_ARG(name, arg)		PROFSCOPE profScope(name, (long)(arg))
+#define PROF_BEGIN(event, name)			long event = ProfBegin(name, 0L)
+#define PROF_END(event)					ProfEnd(event)
+
+#else
+
+#define PROF_SCOPE(name)
+#define PROF_SCOPE_ARG(name, arg)
+#define PROF_BEGIN(event, name)
+#define PROF_END(event)
+
+#endif
 
 /* If we're running inside Xcode, #define'ing _DebugPrintf_ as simply _printf_ is OK:
 then DebugPrintf output will appear in the Run Log window. But if we're not in Xcode,
@@ -25,6 +25,13 @@ extern FASTFLOAT relFSizeTab[];
 void DrawPageContent(Document *, short, Rect *, Rect *);
 void ScrollDrawPage(void);
 void DrawRange(Document *, LINK, LINK, Rect *, Rect *);
+void UseSysPicts(Boolean);
+void BeginPrerender(void);
+Boolean EndPrerender(void);
+void InvalSysPicts(Document *);
+void InvalSysPict(LINK);
+void InvalSysPictsInRect(Document *, Rect *);
+Boolean SysPictRecorded(Document *, LINK, Rect *);
 
 void DrawPAGE(Document *, LINK, Rect *, CONTEXT []);
 void DrawSYSTEM(Document *, LINK, Rect *, CONTEXT []);
@@ -36,5 +36,6 @@ void		EndianFixHeapHdr(Document *doc, HEAP *heap);
 void		EndianFixObject(LINK pL);
 Boolean		EndianFixSubobj(short heapIndex, LINK subL);
 Boolean		EndianFixSubobjs(LINK objL);
+Boolean		EndianFixSubobjHeap(Document *doc, short heapIndex, unsigned short nSubobjs);
 void		EndianFixBMPFileHdr(BMPFileHeader *pFileHdr);
 void		EndianFixBMPInfoHdr(BMPInfoHeader *pInfoHdr);
@@ -11,3 +11,4 @@ Boolean WritePrintHandle(Document *);
 
 FILE *NOpenBMPFile(char *filename, long *pixOffset, short *pWidth, short *pByteWidth,
 		short *pByteWidthWithPad, short *pHeight);
+Boolean NWriteBMPFile(char *filename, Byte *bits, long rowBytes, short width, short height);
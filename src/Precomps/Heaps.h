@@ -1,5 +1,11 @@
 /* Heaps.h for Nightingale - Header file for Heaps.c */
 
+/* "Commands" for heap statistics that aren't menu choices: see SetHeapStatsCommand */
+
+#define HEAPSTATS_IDLE	0L			/* Not handling a mouse click or keystroke */
+#define HEAPSTATS_CLICK	1L			/* Mouse click that isn't a menu choice */
+#define HEAPSTATS_KEY	2L			/* Keystroke that isn't a menu choice */
+
 Boolean		InitAllHeaps(Document *doc);
 void		DestroyAllHeaps(Document *doc);
 Boolean		ExpandFreeList(HEAP *heap, long nObjs);
@@ -9,3 +15,7 @@ LINK		InsertLink(HEAP *heap, LINK head, LINK before, LINK objlist);
 LINK		InsAfterLink(HEAP *heap, LINK head, LINK after, LINK objlist);
 LINK		RemoveLink(LINK objL, HEAP *heap, LINK head, LINK obj);
 Boolean		HeapLinkIsFree(HEAP *heap, LINK link);
+void		SetHeapStatsCommand(long command);
+void		LogHeapStats(Document *doc, Boolean machineReadable);
+Boolean		CompactHeaps(Document *doc, Boolean showDetail);
+Boolean		CompactStringPool(Document *doc);
@@ -446,6 +446,7 @@ pascal OSErr	HandleQUIT(const AppleEvent *appleEvent, AppleEvent *reply, /*unsig
 	void		MagnifyPaper(Rect *paper, Rect *magPaper, short magnify);
 	void		UnmagnifyPaper(Rect *magPaper, Rect *paper, short magnify);
 	void		PickSheetMode(Document *doc, Boolean fromMenu, short sheet);
+	void		PrerenderSheets(Document *doc);
 	Boolean		ScreenPagesCanOverflow(Document *doc, short magnify, short numSheets);
 	Boolean		ScreenPagesExceedView(Document *doc);
 	void		SetCurrentSheet(Document *doc, short sheet, Rect *paper);
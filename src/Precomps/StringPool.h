@@ -356,16 +356,25 @@ typedef void (*NoMemoryFunc)(OSErr err);
 
 /*--------------------------------------
 	PReplaceInPool() replaces a given string in the pool at offset with a given Pascal
-	string, str.  If the new string is not longer than the one it is to replace,
-	then it is stored at the same StringRef as the old one.  If it is longer,
-	then it is allocated its own memory, and stored there as if you had made a
-	call to PStore().  In either case, the StringRef of the newly stored
-	string is returned, or -1 in case of memory error.
+	string, str.  Since the old string may be shared by other references (see
+	PInternInPool()), it is never changed in place: the new string is interned as if
+	you had called PIntern(), and the old one is left as garbage.  The StringRef of
+	the new string is returned, or -1 in case of memory error.
 																							*/
 	StringRef PReplaceInPool(StringRef offset, Byte *str, StringPoolRef pool);
 	#define PReplace(offset,str) PReplaceInPool(offset, str, defaultPool)
 
 
+/*--------------------------------------
+	PInternInPool() is like PStoreInPool(), except that if a Pascal string with the
+	same contents was already interned in the pool, it delivers that string's
+	StringRef instead of storing another copy.  Interned strings may be shared, so
+	they must never be changed in place; use PReplace() to change one reference.
+																							*/
+	StringRef PInternInPool(Byte *str, StringPoolRef pool);
+	#define PIntern(str) PInternInPool(str, defaultPool)
+
+
 /*--------------------------------------
 	PAddrInPool() delivers the address within the pool of the 0'th (length)
 	byte of the Pascal string at the given StringRef.  This address is only good
@@ -123,7 +123,35 @@ void SetDocumentKind(WindowPtr w);
 
 void OffsetContrlRect(ControlRef ctrl, short dx, short dy);
 
+/* LogPrintf ignores messages of lower priority (higher code) than <logLevelLimit>, but
+only after its arguments have been evaluated. LOGPRINTF checks the level first, so the
+arguments, which may be expensive, are never evaluated for ignored messages.
+LOGPRINTF_LIMITED also limits each call site to LOG_RATE_MAX messages a second, for
+messages that could be generated in a loop. */
+
+typedef struct {
+	unsigned long	windowStart;			/* TickCount() at start of current second */
+	short			nInWindow;				/* No. of messages logged in it */
+	long			nSuppressed;			/* No. of messages suppressed and not yet reported */
+} LOGRATE;
+
+#define LOG_RATE_MAX 20
+
+extern short logLevelLimit;
+
+#define LOG_LEVEL_ON(priLevel)	((priLevel)<=logLevelLimit)
+
+#define LOGPRINTF(priLevel, ...)											\
+	do { if (LOG_LEVEL_ON(priLevel)) LogPrintf((priLevel), __VA_ARGS__); } while (0)
+
+#define LOGPRINTF_LIMITED(priLevel, ...)									\
+	do { static LOGRATE logRate;											\
+		if (LOG_LEVEL_ON(priLevel) && LogRateOK(&logRate))					\
+			LogPrintf((priLevel), __VA_ARGS__); } while (0)
+
 void KludgeOS10p5LogDelay(Boolean doDelay);
 Boolean VLogPrintf(const char *fmt, va_list argp);
 Boolean LogPrintf(short priLevel, const char *fmt, ...);
+Boolean LogRateOK(LOGRATE *pRate);
+void FlushLogPrintf(void);
 short InitLogPrintf();
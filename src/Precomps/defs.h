@@ -447,6 +447,12 @@ moved there eventually). */
 #define ENABLE_ENLARGE(doc)		((doc)!=NULL && (doc)->magnify<MAX_MAGNIFY)
 #define ENABLE_GOTO(doc)		((doc)!=NULL && (!(doc)->masterView))
 
+/* At reductions of LOWDETAIL_MAGNIFY or more, accidentals, augmentation dots, and note
+and rest modifiers are only a pixel or two in size; on the screen we don't draw them. */
+
+#define LOWDETAIL_MAGNIFY		-3
+#define DRAW_LOWDETAIL(doc)		(outputTo==toScreen && (doc)->magnify<=LOWDETAIL_MAGNIFY)
+
 /* Get distance between staff lines for given PCONTEXT (DDIST) */
 
 #define LNSPACE(pCont) ((pCont)->staffHeight/((pCont)->staffLines-1))
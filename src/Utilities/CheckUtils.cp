@@ -11,9 +11,23 @@
 #include "Nightingale_Prefix.pch"
 #include "Nightingale.appl.h"
 
+/* One entry in the hit-testing index (see FindAndActOnObject): a clickable object, and
+the last System, Staff, and Measure at or before it in its Page, plus the System and Staff
+in effect at that Measure. */
+
+typedef struct {
+	LINK		objL;
+	LINK		sysL, staffL;
+	LINK		measL, measSysL, measStaffL;
+	Rect		box;					/* objRect, enlarged by HITIDX_SLOP */
+} HITENTRY;
+
 /* Local prototypes */
 
 static short ComputeLimitRTop(Document *, LINK, Rect, Rect, short, PCONTEXT);
+static Boolean GrowHitIndex(Ptr *, long *, long, long);
+static Boolean BuildHitIndex(Document *, LINK, LINK);
+static void HitEntryContext(CONTEXT [], HITENTRY *, CONTEXT []);
 
 
 /* Utilities for CheckSYSTEM */
@@ -465,6 +479,181 @@ Rect SetSubRect(DDIST xd, DDIST dTop, short width, PCONTEXT pContext)
 /* ====================================================================================== */
 /* FindAndActOnObject and utilities */
 
+/* Hit-testing index for FindAndActOnObject. Finding the object that was clicked on used
+to mean walking the entire page, tracking contexts, and testing every object. Instead, we
+keep a two-level index of the current page: for each System, the bounding box of its
+clickable objects, and for each such object, its (slightly enlarged) objRect plus the
+structural objects whose contexts are in effect at it. A click then only has to look at
+Systems whose bounds contain the point and test the few objects that overlap it.
+
+The index is only good until objRects change or the object list is edited, so drawing,
+the Inval routines and the routines that insert or delete nodes all call InvalHitIndex;
+it's rebuilt lazily on the next lookup. */
+
+#define HITIDX_SLOP			2			/* Enlarge objRects by this (pixels); >=ObjectTest's */
+#define HITIDX_INITSIZE		256L		/* Initial no. of entries in the index */
+#define HITIDX_INITBANDS	16L			/* Initial no. of Systems in the index */
+
+typedef struct {
+	long		firstEntry;				/* Index of first entry in this System */
+	long		nEntries;
+	Rect		bounds;					/* Union of boxes of the entries */
+} HITBAND;
+
+static Document	*hitIdxDoc = NULL;			/* Document and Page the index describes */
+static LINK		hitIdxPageL = NILINK;
+static Boolean	hitIdxValid = False;
+static HITENTRY	*hitIdx = NULL;
+static long		hitIdxSize = 0L, nHitIdx = 0L;
+static HITBAND	*hitBand = NULL;
+static long		hitBandSize = 0L, nHitBand = 0L;
+
+
+/* --------------------------------------------------------------------- InvalHitIndex -- */
+/* Mark the hit-testing index as out of date. Cheap, so call it whenever objRects or the
+object list may have changed. */
+
+void InvalHitIndex(void)
+{
+	hitIdxValid = False;
+}
+
+
+/* ---------------------------------------------------------------------- GrowHitIndex -- */
+/* Make sure the block <*pBlock>, of <*pSize> elements of <elSize> bytes each, has room
+for at least <nNeeded> elements, doubling its size as necessary. Return False if we run
+out of memory. */
+
+static Boolean GrowHitIndex(Ptr *pBlock, long *pSize, long nNeeded, long elSize)
+{
+	long newSize;  Ptr newBlock;
+	
+	if (nNeeded<=*pSize) return True;
+	
+	newSize = *pSize;
+	while (newSize<nNeeded) newSize *= 2;
+	newBlock = NewPtr(newSize*elSize);
+	if (!GoodNewPtr(newBlock)) return False;
+	
+	if (*pBlock) {
+		BlockMoveData(*pBlock, newBlock, *pSize*elSize);
+		DisposePtr(*pBlock);
+	}
+	*pBlock = newBlock;
+	*pSize = newSize;
+	return True;
+}
+
+
+/* --------------------------------------------------------------------- BuildHitIndex -- */
+/* Build the hit-testing index for the objects in [pageL, endL), i.e., for one Page.
+Objects are entered in object-list order, so lookups find the same object a walk thru
+the list would. Return False if we run out of memory. */
+
+static Boolean BuildHitIndex(Document *doc, LINK pageL, LINK endL)
+{
+	LINK pL, sysL=NILINK, staffL=NILINK, measL=NILINK, measSysL=NILINK, measStaffL=NILINK;
+	HITENTRY *e;  HITBAND *band;
+	
+	hitIdxValid = False;
+	if (!hitIdx) {
+		hitIdxSize = HITIDX_INITSIZE;
+		hitIdx = (HITENTRY *)NewPtr(hitIdxSize*sizeof(HITENTRY));
+		if (!GoodNewPtr((Ptr)hitIdx)) { hitIdx = NULL; return False; }
+		hitBandSize = HITIDX_INITBANDS;
+		hitBand = (HITBAND *)NewPtr(hitBandSize*sizeof(HITBAND));
+		if (!GoodNewPtr((Ptr)hitBand)) {
+			DisposePtr((Ptr)hitIdx);
+			hitIdx = NULL; hitBand = NULL;
+			return False;
+		}
+	}
+	
+	/* The first "System" holds any objects that precede the Page's first real System. */
+	
+	nHitIdx = 0L;
+	nHitBand = 1L;
+	band = &hitBand[0];
+	band->firstEntry = 0L;
+	band->nEntries = 0L;
+	SetRect(&band->bounds, 0, 0, 0, 0);
+	
+	for (pL = pageL; pL!=endL; pL = RightLINK(pL)) {
+		switch (ObjLType(pL)) {
+			case PAGEtype:
+			case CONNECTtype:
+				continue;
+			case SYSTEMtype:
+				if (!GrowHitIndex((Ptr *)&hitBand, &hitBandSize, nHitBand+1, sizeof(HITBAND)))
+					return False;
+				band = &hitBand[nHitBand++];
+				band->firstEntry = nHitIdx;
+				band->nEntries = 0L;
+				SetRect(&band->bounds, 0, 0, 0, 0);
+				sysL = pL;
+				staffL = NILINK;
+				continue;
+			case STAFFtype:
+				staffL = pL;
+				continue;
+			case MEASUREtype:
+				measL = pL;
+				measSysL = sysL;
+				measStaffL = staffL;
+				break;
+			default:
+				;
+		}
+		if (!VISIBLE(pL)) continue;
+		
+		if (!GrowHitIndex((Ptr *)&hitIdx, &hitIdxSize, nHitIdx+1, sizeof(HITENTRY)))
+			return False;
+		e = &hitIdx[nHitIdx++];
+		e->objL = pL;
+		e->sysL = sysL;
+		e->staffL = staffL;
+		e->measL = measL;
+		e->measSysL = measSysL;
+		e->measStaffL = measStaffL;
+		e->box = LinkOBJRECT(pL);
+		InsetRect(&e->box, -HITIDX_SLOP, -HITIDX_SLOP);
+
+		/* <band> may have moved if hitBand grew, but only when a System was added. */
+		
+		band = &hitBand[nHitBand-1];
+		if (band->nEntries==0) band->bounds = e->box;
+		else				   UnionRect(&band->bounds, &e->box, &band->bounds);
+		band->nEntries++;
+	}
+	
+	hitIdxDoc = doc;
+	hitIdxPageL = pageL;
+	hitIdxValid = True;
+	return True;
+}
+
+
+/* ------------------------------------------------------------------- HitEntryContext -- */
+/* Set <context> to what it would be at the entry's object in a walk thru its Page that
+starts with <pageContext>, the context at the Page's first Measure. The System, Staff,
+and Measure Context routines each overwrite everything the previous object of the same
+type set, so only the last of each before the object matters. */
+
+static void HitEntryContext(CONTEXT pageContext[], HITENTRY *e, CONTEXT context[])
+{
+	BlockMoveData(pageContext, context, (MAXSTAVES+1)*sizeof(CONTEXT));
+	
+	if (e->measL) {
+		if (e->measSysL) ContextSystem(e->measSysL, context);
+		if (e->measStaffL) ContextStaff(e->measStaffL, context);
+		ContextMeasure(e->measL, context);
+		if (e->sysL==e->measSysL) return;
+	}
+	if (e->sysL) ContextSystem(e->sysL, context);
+	if (e->staffL) ContextStaff(e->staffL, context);
+}
+
+
 /* --------------------------------------------------------------------- ContextObject -- */
 /* While traversing the object list, update the context array by calling the appropriate
 Context routine at any structural object encountered. */
@@ -695,42 +884,48 @@ The calling routine is responsible for updating the selection range. */
 
 LINK FindAndActOnObject(Document *doc, Point pt, short *pIndex, short checkMode)
 {
-	LINK		pL, firstMeas, endL;
-	CONTEXT		context[MAXSTAVES+1];
+	LINK		pL, pageL, firstMeas, endL;
+	CONTEXT		context[MAXSTAVES+1], pageContext[MAXSTAVES+1];
 	STFRANGE	stfRange = {0,0};
 	Point		noEnlarge = {0,0};
 	Point		enlargeNR;
+	long		b, i, iEnd;
+	Boolean		havePageContext=False;
+
+	PROF_SCOPE("FindAndActOnObject");
 
 	SetPt(&enlargeNR, config.enlargeNRHiliteH, config.enlargeNRHiliteV);
 
 	BuildCharRectCache(doc);						/* ensure charRectCache valid */
 	
-	pL = GetCurrentPage(doc); 
-	endL = LinkRPAGE(pL);
+	pageL = GetCurrentPage(doc); 
+	endL = LinkRPAGE(pageL);
 	if (endL == NILINK) endL = doc->tailL;
 	
-	for ( ; pL!=endL; pL=RightLINK(pL)) {			/* find object that was clicked in */
-		switch (ObjLType(pL)) {
-			case PAGEtype:
-				firstMeas = LSSearch(pL, MEASUREtype, ANYONE, False, False);
-				GetAllContexts(doc, context, firstMeas);
-				break;
-			case SYSTEMtype:
-				ContextSystem(pL, context);
-				break;
-			case STAFFtype:
-				ContextStaff(pL, context);
-				break;
-			case MEASUREtype:
-				ContextMeasure(pL, context);
-				break;
-			case CONNECTtype:
-				break;
-			default:
-				break;
+	if (!hitIdxValid || hitIdxDoc!=doc || hitIdxPageL!=pageL)
+		if (!BuildHitIndex(doc, pageL, endL)) {
+			NoMoreMemory();
+			return NILINK;
 		}
-
-		if (VISIBLE(pL))
+	
+	/* Find object that was clicked in: look only at objects whose boxes contain the
+	   point in Systems whose bounds contain it. */
+	   
+	for (b = 0; b<nHitBand; b++) {
+		if (hitBand[b].nEntries==0 || !PtInRect(pt, &hitBand[b].bounds)) continue;
+		iEnd = hitBand[b].firstEntry+hitBand[b].nEntries;
+		for (i = hitBand[b].firstEntry; i<iEnd; i++) {
+			if (!PtInRect(pt, &hitIdx[i].box)) continue;
+			pL = hitIdx[i].objL;
+			if (!VISIBLE(pL)) continue;
+			
+			if (!havePageContext) {
+				firstMeas = LSSearch(pageL, MEASUREtype, ANYONE, False, False);
+				GetAllContexts(doc, pageContext, firstMeas);
+				havePageContext = True;
+			}
+			HitEntryContext(pageContext, &hitIdx[i], context);
+			
 			if (ObjectTest(&context->paper, pt, pL)) {
 				switch (ObjLType(pL)) {
 					case PAGEtype:
@@ -811,6 +1006,7 @@ LINK FindAndActOnObject(Document *doc, Point pt, short *pIndex, short checkMode)
 						*pIndex = 0;
 						return pL;
 				}
+			}
 		}
 	}
 
@@ -31,6 +31,7 @@
 
 extern short nerr, errLim;
 extern Boolean minDebugCheck;			/* True = don't print Less and Least important checks */
+extern Boolean dcheckHeadless;			/* True = checking with no user interface */
 
 #ifdef DDB
 
@@ -39,7 +40,7 @@ Boolean QDP(char *fmtStr)
 	Boolean printAll = !minDebugCheck;
 
 	if (printAll || (*fmtStr=='*' || *fmtStr=='•')) {
-		SysBeep(8);
+		if (!dcheckHeadless) SysBeep(8);
 		nerr++;
 		return True;
 	}
@@ -28,6 +28,7 @@ as a result, the EndianFixStringPool code is located in StringPool.c. */
 
 #include "Nightingale_Prefix.pch"
 #include <Carbon/Carbon.h>
+#include <stddef.h>
 
 #include "Nightingale.appl.h"
 
@@ -45,13 +46,6 @@ void EndianFixPoint(Point *pPoint)
 	FIX_END(pPoint->h);
 }
 
-static void EndianFixDPoint(DPoint *pPoint);
-static void EndianFixDPoint(DPoint *pPoint)
-{
-	FIX_END(pPoint->v);
-	FIX_END(pPoint->h);
-}
-
 static void EndianFixTextstyleRecord(TEXTSTYLE *pTSRec);
 static void EndianFixTextstyleRecord(TEXTSTYLE *pTSRec)
 {
@@ -241,132 +235,233 @@ void EndianFixHeapHdr(Document * /* doc */, HEAP *heap)
 
 
 /* ----------------------------------------- Endian functions for objects & subobjects -- */
+/* The multibyte fields of each type of object and subobject are at fixed positions, so
+instead of swapping them one at a time in a switch on the type, we describe them in a
+table for each type: a list of runs of consecutive 2- or 4-byte fields, ending with a
+run of size 0. Swapping an object or subobject is then just a pass over its type's
+table, and swapping a whole subobject heap just repeats that pass at a fixed stride. */
 
-void EndianFixObject(LINK objL)
+typedef struct {
+	unsigned short	offset;				/* Offset of the first field in the record */
+	unsigned char	size;				/* Size of each field: 2 or 4 bytes */
+	unsigned char	count;				/* No. of consecutive fields of that size */
+} ENDIANFIELD;
+
+#define EF_FIELD(type, field)		{ offsetof(type, field), sizeof(((type *)0)->field), 1 }
+#define EF_SHORTS(type, field, n)	{ offsetof(type, field), sizeof(short), n }
+#define EF_END						{ 0, 0, 0 }
+
+/* Every object begins with its right, left, and firstSubObj LINKs and its xd and yd. */
+
+#define EF_OBJHEADER				{ 0, sizeof(LINK), 5 }
+
+/* Every subobject begins with its <next> LINK. Besides that, the SUBOBJHEADER has no
+multibyte fields. */
+
+#define EF_SUBOBJHEADER				{ 0, sizeof(LINK), 1 }
+
+static const ENDIANFIELD efObjHdrOnly[] = { EF_OBJHEADER, EF_END };
+
+static const ENDIANFIELD efSYNC[] = { EF_OBJHEADER, EF_FIELD(SYNC, timeStamp), EF_END };
+
+static const ENDIANFIELD efRPTEND[] = { EF_OBJHEADER, EF_FIELD(RPTEND, firstObj),
+	EF_FIELD(RPTEND, startRpt), EF_FIELD(RPTEND, endRpt), EF_END };
+
+static const ENDIANFIELD efPAGE[] = { EF_OBJHEADER, EF_FIELD(PAGE, lPage),
+	EF_FIELD(PAGE, rPage), EF_FIELD(PAGE, sheetNum), EF_END };
+
+static const ENDIANFIELD efSYSTEM[] = { EF_OBJHEADER, EF_FIELD(SYSTEM, lSystem),
+	EF_FIELD(SYSTEM, rSystem), EF_FIELD(SYSTEM, systemNum),
+	EF_SHORTS(SYSTEM, systemRect, 4), EF_FIELD(SYSTEM, pageL), EF_END };
+
+static const ENDIANFIELD efSTAFF[] = { EF_OBJHEADER, EF_FIELD(STAFF, lStaff),
+	EF_FIELD(STAFF, rStaff), EF_FIELD(STAFF, systemL), EF_END };
+
+static const ENDIANFIELD efMEASURE[] = { EF_OBJHEADER, EF_FIELD(MEASURE, lMeasure),
+	EF_FIELD(MEASURE, rMeasure), EF_FIELD(MEASURE, fakeMeas),
+	EF_FIELD(MEASURE, spacePercent), EF_FIELD(MEASURE, staffL),
+	EF_SHORTS(MEASURE, measureBBox, 4), EF_FIELD(MEASURE, lTimeStamp), EF_END };
+
+static const ENDIANFIELD efDYNAMIC[] = { EF_OBJHEADER, EF_FIELD(DYNAMIC, firstSyncL),
+	EF_FIELD(DYNAMIC, lastSyncL), EF_END };
+
+static const ENDIANFIELD efGRAPHIC[] = { EF_OBJHEADER, EF_FIELD(GRAPHIC, info),
+	EF_FIELD(GRAPHIC, gu.thickness), EF_FIELD(GRAPHIC, fontStyle),
+	EF_FIELD(GRAPHIC, info2), EF_FIELD(GRAPHIC, firstObj), EF_FIELD(GRAPHIC, lastObj),
+	EF_END };
+
+static const ENDIANFIELD efOTTAVA[] = { EF_OBJHEADER, EF_FIELD(OTTAVA, xdFirst),
+	EF_FIELD(OTTAVA, ydFirst), EF_FIELD(OTTAVA, xdLast), EF_FIELD(OTTAVA, ydLast),
+	EF_END };
+
+static const ENDIANFIELD efSLUR[] = { EF_OBJHEADER, EF_FIELD(SLUR, firstSyncL),
+	EF_FIELD(SLUR, lastSyncL), EF_END };
+
+static const ENDIANFIELD efTUPLET[] = { EF_OBJHEADER, EF_FIELD(TUPLET, acnxd),
+	EF_FIELD(TUPLET, acnyd), EF_FIELD(TUPLET, xdFirst), EF_FIELD(TUPLET, ydFirst),
+	EF_FIELD(TUPLET, xdLast), EF_FIELD(TUPLET, ydLast), EF_END };
+
+static const ENDIANFIELD efTEMPO[] = { EF_OBJHEADER, EF_FIELD(TEMPO, tempoMM),
+	EF_FIELD(TEMPO, strOffset), EF_FIELD(TEMPO, firstObjL),
+	EF_FIELD(TEMPO, metroStrOffset), EF_END };
+
+static const ENDIANFIELD efSPACER[] = { EF_OBJHEADER, EF_FIELD(SPACER, spWidth), EF_END };
+
+static const ENDIANFIELD efENDING[] = { EF_OBJHEADER, EF_FIELD(ENDING, firstObjL),
+	EF_FIELD(ENDING, lastObjL), EF_FIELD(ENDING, endxd), EF_END };
+
+static const ENDIANFIELD efSubHdrOnly[] = { EF_SUBOBJHEADER, EF_END };
+
+static const ENDIANFIELD efPARTINFO[] = { EF_SUBOBJHEADER, EF_FIELD(PARTINFO, hiKeyNum),
+	EF_FIELD(PARTINFO, loKeyNum), EF_END };
+
+static const ENDIANFIELD efANOTE[] = { EF_SUBOBJHEADER, EF_FIELD(ANOTE, xd),
+	EF_FIELD(ANOTE, yd), EF_FIELD(ANOTE, ystem), EF_FIELD(ANOTE, playTimeDelta),
+	EF_FIELD(ANOTE, playDur), EF_FIELD(ANOTE, pTime), EF_FIELD(ANOTE, firstMod),
+	EF_END };
+
+static const ENDIANFIELD efASTAFF[] = { EF_SUBOBJHEADER, EF_FIELD(ASTAFF, staffTop),
+	EF_FIELD(ASTAFF, staffLeft), EF_FIELD(ASTAFF, staffRight),
+	EF_FIELD(ASTAFF, staffHeight), EF_FIELD(ASTAFF, fontSize),
+	EF_FIELD(ASTAFF, flagLeading), EF_FIELD(ASTAFF, minStemFree),
+	EF_FIELD(ASTAFF, ledgerWidth), EF_FIELD(ASTAFF, noteHeadWidth),
+	EF_FIELD(ASTAFF, fracBeamWidth), EF_FIELD(ASTAFF, spaceBelow), EF_END };
+
+static const ENDIANFIELD efAMEASURE[] = { EF_SUBOBJHEADER,
+	EF_FIELD(AMEASURE, measureNum), EF_SHORTS(AMEASURE, measSizeRect, 4), EF_END };
+
+static const ENDIANFIELD efAKEYSIG[] = { EF_SUBOBJHEADER, EF_FIELD(AKEYSIG, xd), EF_END };
+
+static const ENDIANFIELD efATIMESIG[] = { EF_SUBOBJHEADER, EF_FIELD(ATIMESIG, xd),
+	EF_FIELD(ATIMESIG, yd), EF_END };
+
+static const ENDIANFIELD efANOTEBEAM[] = { EF_SUBOBJHEADER, EF_FIELD(ANOTEBEAM, bpSync),
+	EF_END };
+
+static const ENDIANFIELD efACONNECT[] = { EF_SUBOBJHEADER, EF_FIELD(ACONNECT, xd),
+	EF_FIELD(ACONNECT, firstPart), EF_FIELD(ACONNECT, lastPart), EF_END };
+
+static const ENDIANFIELD efADYNAMIC[] = { EF_SUBOBJHEADER, EF_FIELD(ADYNAMIC, xd),
+	EF_FIELD(ADYNAMIC, yd), EF_FIELD(ADYNAMIC, endxd), EF_FIELD(ADYNAMIC, endyd),
+	EF_END };
+
+static const ENDIANFIELD efAGRAPHIC[] = { EF_SUBOBJHEADER, EF_FIELD(AGRAPHIC, strOffset),
+	EF_END };
+
+static const ENDIANFIELD efANOTEOTTAVA[] = { EF_SUBOBJHEADER,
+	EF_FIELD(ANOTEOTTAVA, opSync), EF_END };
+
+/* A slur's <bounds> is a Rect, <seg> is three DPoints, and <startPt>, <endPt> and
+<endKnot> are two Points and a DPoint: all just runs of shorts. */
+
+static const ENDIANFIELD efASLUR[] = { EF_SUBOBJHEADER, EF_SHORTS(ASLUR, bounds, 4),
+	EF_SHORTS(ASLUR, seg, 6), EF_SHORTS(ASLUR, startPt, 2), EF_SHORTS(ASLUR, endPt, 2),
+	EF_SHORTS(ASLUR, endKnot, 2), EF_END };
+
+static const ENDIANFIELD efANOTETUPLE[] = { EF_SUBOBJHEADER,
+	EF_FIELD(ANOTETUPLE, tpSync), EF_END };
+
+static const ENDIANFIELD *objFieldTable[LASTtype];
+static const ENDIANFIELD *subobjFieldTable[LASTtype];
+
+static void InitEndianFieldTables(void);
+static void EndianFixFields(char *pRec, const ENDIANFIELD *pField);
+
+/* Fill in the tables of field runs for each type of object and subobject. MODNRs are
+never objects, so that type gets no object table. Types that never have subobjects
+(TAIL, PAGE, SYSTEM, TEMPO, SPACER, ENDING) get just the SUBOBJHEADER, as before. */
+
+static void InitEndianFieldTables()
 {
-	/* First, handle OBJECTHEADER fields, which are common to all objects. */
+	static Boolean inited = False;
+	short type;
 	
-//LogPrintf(LOG_DEBUG, "EndianFixObject1: objL=%u LeftLINK(objL)=%u\n", objL, LeftLINK(objL));
-	FIX_END(LeftLINK(objL));
-//LogPrintf(LOG_DEBUG, "EndianFixObject2: objL=%u LeftLINK(objL)=%u\n", objL, LeftLINK(objL));
-	FIX_END(RightLINK(objL));
-	FIX_END(FirstSubLINK(objL));
-	FIX_END(LinkXD(objL));
-	FIX_END(LinkYD(objL));
+	if (inited) return;
+	
+	for (type = 0; type<LASTtype; type++)
+		objFieldTable[type] = NULL;
+
+	objFieldTable[HEADERtype] = efObjHdrOnly;
+	objFieldTable[TAILtype] = efObjHdrOnly;
+	objFieldTable[SYNCtype] = efSYNC;
+	objFieldTable[RPTENDtype] = efRPTEND;
+	objFieldTable[PAGEtype] = efPAGE;
+	objFieldTable[SYSTEMtype] = efSYSTEM;
+	objFieldTable[STAFFtype] = efSTAFF;
+	objFieldTable[MEASUREtype] = efMEASURE;
+	objFieldTable[CLEFtype] = efObjHdrOnly;
+	objFieldTable[KEYSIGtype] = efObjHdrOnly;
+	objFieldTable[TIMESIGtype] = efObjHdrOnly;
+	objFieldTable[BEAMSETtype] = efObjHdrOnly;
+	objFieldTable[CONNECTtype] = efObjHdrOnly;
+	objFieldTable[DYNAMtype] = efDYNAMIC;
+	objFieldTable[GRAPHICtype] = efGRAPHIC;
+	objFieldTable[OTTAVAtype] = efOTTAVA;
+	objFieldTable[SLURtype] = efSLUR;
+	objFieldTable[TUPLETtype] = efTUPLET;
+	objFieldTable[GRSYNCtype] = efObjHdrOnly;
+	objFieldTable[TEMPOtype] = efTEMPO;
+	objFieldTable[SPACERtype] = efSPACER;
+	objFieldTable[ENDINGtype] = efENDING;
+	objFieldTable[PSMEAStype] = efObjHdrOnly;
+
+	for (type = 0; type<LASTtype; type++)
+		subobjFieldTable[type] = efSubHdrOnly;
+	subobjFieldTable[HEADERtype] = efPARTINFO;
+	subobjFieldTable[SYNCtype] = efANOTE;
+	subobjFieldTable[STAFFtype] = efASTAFF;
+	subobjFieldTable[MEASUREtype] = efAMEASURE;
+	subobjFieldTable[KEYSIGtype] = efAKEYSIG;
+	subobjFieldTable[TIMESIGtype] = efATIMESIG;
+	subobjFieldTable[BEAMSETtype] = efANOTEBEAM;
+	subobjFieldTable[CONNECTtype] = efACONNECT;
+	subobjFieldTable[DYNAMtype] = efADYNAMIC;
+	subobjFieldTable[GRAPHICtype] = efAGRAPHIC;
+	subobjFieldTable[OTTAVAtype] = efANOTEOTTAVA;
+	subobjFieldTable[SLURtype] = efASLUR;
+	subobjFieldTable[TUPLETtype] = efANOTETUPLE;
+	subobjFieldTable[GRSYNCtype] = efANOTE;				/* AGRNOTE is the same struct */
+
+	inited = True;
+}
 
-	/* Now handle object-type-specific fields. */
+/* Swap the byte order of the fields described by <pField> in the record at <pRec>. */
 
-	switch (ObjLType(objL)) {
-		case HEADERtype:
-			break;
-		case TAILtype:
-			break;
-		case SYNCtype:
-			FIX_END(SyncTIME(objL));
-			break;
-		case RPTENDtype:
-			FIX_END(RptEndFIRSTOBJ(objL));
-			FIX_END(RptEndSTARTRPT(objL));
-			FIX_END(RptEndENDRPT(objL));
-			break;
-		case PAGEtype:
-			FIX_END(LinkLPAGE(objL));
-			FIX_END(LinkRPAGE(objL));
-			FIX_END(SheetNUM(objL));
-			break;
-		case SYSTEMtype:
-			FIX_END(LinkLSYS(objL));
-			FIX_END(LinkRSYS(objL));
-			FIX_END(SystemNUM(objL));
-			EndianFixRect((Rect *)&SystemRECT(objL));
-			FIX_END(SysPAGE(objL));
-			break;
-		case STAFFtype:
-			FIX_END(LinkLSTAFF(objL));
-			FIX_END(LinkRSTAFF(objL));
-			FIX_END(StaffSYS(objL));
-			break;
-		case MEASUREtype:
-			FIX_END(LinkLMEAS(objL));
-			FIX_END(LinkRMEAS(objL));
-			FIX_END(MeasISFAKE(objL));
-			FIX_END(MeasSPACEPCT(objL));
-			FIX_END(MeasSTAFFL(objL));
-			EndianFixRect(&MeasureBBOX(objL));
-			FIX_END(MeasureTIME(objL));
-			break;
-		case CLEFtype:
-			break;
-		case KEYSIGtype:
-			break;
-		case TIMESIGtype:
-			break;
-		case BEAMSETtype:
-			break;
-		case CONNECTtype:
-			break;
-		case DYNAMtype:
-			FIX_END(DynamFIRSTSYNC(objL));
-			FIX_END(DynamLASTSYNC(objL));
-			break;
-		case MODNRtype: 		/* There are no objects of this type, only subobjects. */
-			break;
-		case GRAPHICtype:
-			FIX_END(GraphicINFO(objL));
-			FIX_END(GraphicTHICKNESS(objL));
-			FIX_END(GraphicFONTSTYLE(objL));
-			FIX_END(GraphicINFO2(objL));
-			FIX_END(GraphicFIRSTOBJ(objL));
-			FIX_END(GraphicLASTOBJ(objL));
-			break;
-		case OTTAVAtype:
-			FIX_END(OttavaXDFIRST(objL));
-			FIX_END(OttavaYDFIRST(objL));
-			FIX_END(OttavaXDLAST(objL));
-			FIX_END(OttavaYDLAST(objL));
-			break;
-		case SLURtype:
-			FIX_END(SlurFIRSTSYNC(objL));
-			FIX_END(SlurLASTSYNC(objL));
-			break;
-		case TUPLETtype:
-			FIX_END(TupletACNXD(objL));
-			FIX_END(TupletACNYD(objL));
-			FIX_END(TupletXDFIRST(objL));
-			FIX_END(TupletYDFIRST(objL));
-			FIX_END(TupletXDLAST(objL));
-			FIX_END(TupletYDLAST(objL));
-			break;
-		case GRSYNCtype:
-			break;
-		case TEMPOtype:
-			FIX_END(TempoMM(objL));
-			FIX_END(TempoSTRING(objL));
-			FIX_END(TempoFIRSTOBJ(objL));
-			FIX_END(TempoMETROSTR(objL));
-			break;
-		case SPACERtype:
-			FIX_END(SpacerSPWIDTH(objL));
-			break;
-		case ENDINGtype:
-			FIX_END(EndingFIRSTOBJ(objL));
-			FIX_END(EndingLASTOBJ(objL));
-			FIX_END(EndingENDXD(objL));
-			break;
-		case PSMEAStype:
-			break;
-		default:
-			MayErrMsg("Object at L%ld has illegal type %ld.  (EndianFixObject)",
-						(long)objL, (long)ObjLType(objL));
+static void EndianFixFields(char *pRec, const ENDIANFIELD *pField)
+{
+#if TARGET_RT_LITTLE_ENDIAN
+	short n;
+	UInt16 *p16;
+	UInt32 *p32;
+	
+	for ( ; pField->size!=0; pField++) {
+		if (pField->size==2) {
+			p16 = (UInt16 *)(pRec+pField->offset);
+			for (n = 0; n<pField->count; n++, p16++)
+				*p16 = CFSwapInt16BigToHost(*p16);
+		}
+		else {
+			p32 = (UInt32 *)(pRec+pField->offset);
+			for (n = 0; n<pField->count; n++, p32++)
+				*p32 = CFSwapInt32BigToHost(*p32);
+		}
 	}
+#endif
 }
 
-void EndianFixSplineSeg(SplineSeg *seg);
-void EndianFixSplineSeg(SplineSeg *seg)
+
+void EndianFixObject(LINK objL)
 {
-	EndianFixDPoint(&seg->knot);
-	EndianFixDPoint(&seg->c0);
-	EndianFixDPoint(&seg->c1);
+	short type = ObjLType(objL);
+
+	InitEndianFieldTables();
+	if (type<0 || type>=LASTtype || !objFieldTable[type]) {
+		MayErrMsg("Object at L%ld has illegal type %ld.  (EndianFixObject)",
+					(long)objL, (long)type);
+		return;
+	}
+	
+	EndianFixFields((char *)LinkToPtr(OBJheap, objL), objFieldTable[type]);
 }
 
 /* Switch Endian-ness of the given subobject. Return False if we find a problem. */
@@ -382,119 +477,41 @@ Boolean EndianFixSubobj(short heapIndex, LINK subL)
 		return False;
 	}
 
-	/* First, handle the <next> field, which is common to all objects. (The other
-	   SUBOBJHEADER fields are common to all but HEADER subobjs, but none of them
-	   are multiple bytes, so there's nothing else to do for the SUBOBJHEADER.) */
-	
-	FIX_END(NextLink(myHeap, subL));
+	InitEndianFieldTables();
+	if (heapIndex<0 || heapIndex>=LASTtype || !subobjFieldTable[heapIndex]) {
+		MayErrMsg("For subobject at L%ld, type %ld is illegal.  (EndianFixSubobj)",
+					(long)subL, (long)heapIndex);
+		return False;
+	}
 
-	/* Now handle subobject-type-specific fields. */
+	EndianFixFields((char *)LinkToPtr(myHeap, subL), subobjFieldTable[heapIndex]);
+	return True;
+}
 
-	switch (heapIndex) {
-		case HEADERtype:
-			FIX_END(PartHiKEYNUM(subL));
-			FIX_END(PartLoKEYNUM(subL));
-			break;
-		case TAILtype:								/* No subobjects */
-			break;
-		case SYNCtype:
-			FIX_END(NoteXD(subL));
-			FIX_END(NoteYD(subL));
-			FIX_END(NoteYSTEM(subL));
-			FIX_END(NotePLAYTIMEDELTA(subL));
-			FIX_END(NotePLAYDUR(subL));
-			FIX_END(NotePTIME(subL));
-			FIX_END(NoteFIRSTMOD(subL));
-			break;
-		case RPTENDtype:							/* No multibyte fields except <next> */
-			break;
-		case PAGEtype:								/* No subobjects */
-			break;
-		case SYSTEMtype:							/* No subobjects */
-			break;
-		case STAFFtype:
-			FIX_END(StaffTOP(subL));
-			FIX_END(StaffLEFT(subL));
-			FIX_END(StaffRIGHT(subL));
-			FIX_END(StaffHEIGHT(subL));
-			FIX_END(StaffFONTSIZE(subL));
-			FIX_END(StaffFLAGLEADING(subL));
-			FIX_END(StaffMINSTEMFREE(subL));
-			FIX_END(StaffLEDGERWIDTH(subL));
-			FIX_END(StaffNOTEHEADWIDTH(subL));
-			FIX_END(StaffFRACBEAMWIDTH(subL));
-			FIX_END(StaffSPACEBELOW(subL));
-			/* KSINFO has no multibyte fields */
-			break;
-		case MEASUREtype:
-			FIX_END(MeasMEASURENUM(subL));
-			EndianFixRect((Rect *)&MeasMRECT(subL));
-			/* KSINFO has no multibyte fields */
-			break;
-		case CLEFtype:							/* No multibyte fields except <next> */
-			break;
-		case KEYSIGtype:
-			FIX_END(KeySigXD(subL));
-			break;
-		case TIMESIGtype:
-			FIX_END(TimeSigXD(subL));
-			FIX_END(TimeSigYD(subL));
-			break;
-		case BEAMSETtype:
-			FIX_END(NoteBeamBPSYNC(subL));
-			break;
-		case CONNECTtype:
-			FIX_END(ConnectXD(subL));
-			FIX_END(ConnectFIRSTPART(subL));
-			FIX_END(ConnectLASTPART(subL));
-			break;
- 		case DYNAMtype:
-			FIX_END(DynamicXD(subL));
-			FIX_END(DynamicYD(subL));
-			FIX_END(DynamicENDXD(subL));
-			FIX_END(DynamicENDYD(subL));
-			break;
-		case MODNRtype:							/* No multibyte fields except <next> */
-			break;
-		case GRAPHICtype:
-			FIX_END(GraphicSTRING(subL));
-			break;
-		case OTTAVAtype:
-			FIX_END(NoteOttavaOPSYNC(subL));
-			break;
-		case SLURtype:
-			EndianFixRect(&SlurBOUNDS(subL));
-			EndianFixSplineSeg(&SlurSEG(subL));
-			EndianFixPoint(&SlurSTARTPT(subL));
-			EndianFixPoint(&SlurENDPT(subL));
-			EndianFixPoint((Point *)&SlurENDKNOT(subL));		
-			break;
-		case TUPLETtype:
-			FIX_END(NoteTupleTPSYNC(subL));
-			break;
-		case GRSYNCtype:
-			FIX_END(GRNoteXD(subL));
-			FIX_END(GRNoteYD(subL));
-			FIX_END(GRNoteYSTEM(subL));
-			FIX_END(GRNotePLAYTIMEDELTA(subL));
-			FIX_END(GRNotePLAYDUR(subL));
-			FIX_END(GRNotePTIME(subL));
-			FIX_END(GRNoteFIRSTMOD(subL));
-			break;
-		case TEMPOtype:								/* No subobjects */
-			break;
-		case SPACERtype:							/* No subobjects */
-			break;
-		case ENDINGtype:							/* No subobjects */
-			break;
-		case PSMEAStype:							/* No multibyte fields except <next> */
-			break;
-		default:
-			MayErrMsg("For subobject at L%ld, type %ld is illegal.  (EndianFixSubobj)",
-						(long)subL, (long)heapIndex);
-			return False;
+/* Switch Endian-ness of subobjects 1 thru <nSubobjs> of the given heap, all at once.
+This is intended for use right after a subobject heap has been read from a file in the
+current format, where they're exactly the subobjects in the file, in order; in that
+situation, it's equivalent to calling EndianFixSubobjs() for every object, but much
+faster. Return False if we find a problem. */
+
+Boolean EndianFixSubobjHeap(Document *doc, short heapIndex, unsigned short nSubobjs)
+{
+	HEAP *myHeap = doc->Heap + heapIndex;
+	const ENDIANFIELD *pField;
+	char *pRec;
+	unsigned short n;
+
+	InitEndianFieldTables();
+	if (heapIndex<0 || heapIndex>=LASTtype) {
+		MayErrMsg("Heap type %ld is illegal.  (EndianFixSubobjHeap)", (long)heapIndex);
+		return False;
 	}
+	pField = subobjFieldTable[heapIndex];
+	if (!pField || nSubobjs==0) return True;
 
+	pRec = (char *)LinkToPtr(myHeap, 1);
+	for (n = 1; n<=nSubobjs; n++, pRec += myHeap->objSize)
+		EndianFixFields(pRec, pField);
 	return True;
 }
 
@@ -640,9 +657,12 @@ void EndianFixBMPInfoHdr(BMPInfoHeader *pInfoHdr)
 	FIX_END_LE(pInfoHdr->infoHdrSize);
 	FIX_END_LE(pInfoHdr->width);
 	FIX_END_LE(pInfoHdr->height);
+	FIX_END_LE(pInfoHdr->planes);
 	FIX_END_LE(pInfoHdr->bits);
+	FIX_END_LE(pInfoHdr->compression);
 	FIX_END_LE(pInfoHdr->imageSize);
 	FIX_END_LE(pInfoHdr->xResolution);
 	FIX_END_LE(pInfoHdr->yResolution);
 	FIX_END_LE(pInfoHdr->colors);
+	FIX_END_LE(pInfoHdr->importantColors);
 }
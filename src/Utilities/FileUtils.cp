@@ -530,3 +530,75 @@ firstCall = False;
 
 	return bmpf;
 }
+
+
+/* --------------------------------------------------------------------- NWriteBMPFile -- */
+/* Write a black-and-white image to the given file as a 1-bit-per-pixel BMP. <bits>
+points to <height> rows of <rowBytes> bytes each, top row first, in QuickDraw's format
+for a 1-bit deep PixMap (1=black). Returns True if all went well. */
+
+#define BMP_ROW_BUFSIZE 1024
+
+Boolean NWriteBMPFile(char *filename, Byte *bits, long rowBytes, short width, short height)
+{
+	FILE *bmpf;
+	BMPFileHeader fileHdr;
+	BMPInfoHeader infoHdr;
+	Byte palette[4*BITMAP_NCOLORS] = { 255, 255, 255, 0,  0, 0, 0, 0 };	/* White, black */
+	Byte rowBuf[BMP_ROW_BUFSIZE];
+	long byteWidth, byteWidthPadded, imageSize;
+	short row;
+	Boolean okay = False;
+	
+	byteWidth = (width+7)/8;
+	byteWidthPadded = 4*((byteWidth+3)/4);
+	if (byteWidthPadded>BMP_ROW_BUFSIZE || byteWidth>rowBytes) {
+		LogPrintf(LOG_ERR, "Image width of %d is too large for a BMP file.  (NWriteBMPFile)\n",
+					width);
+		return False;
+	}
+	imageSize = byteWidthPadded*height;
+	
+	errno = 0;
+	bmpf = fopen((const char *)filename, "wb");
+	if (!bmpf) {
+		LogPrintf(LOG_ERR, "Can't create bitmap image file '%s'. errno=%d  (NWriteBMPFile)\n",
+					filename, errno);
+		return False;
+	}
+	
+	fileHdr.offsetToPixelArray = 2+sizeof(BMPFileHeader)+sizeof(BMPInfoHeader)+sizeof(palette);
+	fileHdr.fileSize = fileHdr.offsetToPixelArray+imageSize;
+	fileHdr.reserved1 = fileHdr.reserved2 = 0;
+	EndianFixBMPFileHdr(&fileHdr);
+
+	infoHdr.infoHdrSize = sizeof(BMPInfoHeader);
+	infoHdr.width = width;
+	infoHdr.height = height;							/* Positive: rows are bottom-up */
+	infoHdr.planes = 1;
+	infoHdr.bits = 1;
+	infoHdr.compression = 0;
+	infoHdr.imageSize = imageSize;
+	infoHdr.xResolution = infoHdr.yResolution = 2835;	/* 72 dpi, in pixels per meter */
+	infoHdr.colors = BITMAP_NCOLORS;
+	infoHdr.importantColors = 0;
+	EndianFixBMPInfoHdr(&infoHdr);
+	
+	if (fwrite("BM", 2, 1, bmpf)!=1) goto Done;
+	if (fwrite(&fileHdr, sizeof(BMPFileHeader), 1, bmpf)!=1) goto Done;
+	if (fwrite(&infoHdr, sizeof(BMPInfoHeader), 1, bmpf)!=1) goto Done;
+	if (fwrite(palette, sizeof(palette), 1, bmpf)!=1) goto Done;
+	
+	memset(rowBuf, 0, byteWidthPadded);
+	for (row = height-1; row>=0; row--) {
+		BlockMoveData(bits+row*rowBytes, rowBuf, byteWidth);
+		if (fwrite(rowBuf, byteWidthPadded, 1, bmpf)!=1) goto Done;
+	}
+	okay = True;
+	
+Done:
+	if (!okay) LogPrintf(LOG_ERR, "Error writing bitmap image file '%s'.  (NWriteBMPFile)\n",
+							filename);
+	if (fclose(bmpf)!=0) okay = False;
+	return okay;
+}
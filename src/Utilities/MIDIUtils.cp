@@ -174,7 +174,7 @@ Boolean GetModNREffects(LINK aNoteL, short *pVelOffset, short *pDurFactor,
 	for ( ; aModNRL; aModNRL = NextMODNRL(aModNRL)) {
 		Byte code = ModNRMODCODE(aModNRL);
 		if (code>31) {										/* Arrays sized for 32 items. */
-			LogPrintf(LOG_WARNING, "Illegal modifier code %d.  (GetModNREffects)\n", code);
+			LOGPRINTF_LIMITED(LOG_WARNING, "Illegal modifier code %d.  (GetModNREffects)\n", code);
 			continue;
 		}
 		velOffset += modNRVelOffsets[code];
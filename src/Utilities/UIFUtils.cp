@@ -24,7 +24,8 @@
 		SmartenQuote			DrawBox					DrawGrowBox
 		DrawTheSelection		
 		Voice2UserStr			Staff2UserStr
-		VLogPrintf				LogPrintf				InitLogPrintf	
+		VLogPrintf				LogPrintf				LogRateOK
+		FlushLogPrintf			InitLogPrintf
 /******************************************************************************************/
 
 /*
@@ -38,6 +39,10 @@
 #include "Nightingale_Prefix.pch"
 #include "Nightingale.appl.h"
 
+#include <pthread.h>
+#include <sys/time.h>
+#include <libkern/OSAtomic.h>
+
 
 /* --------------------------------------------------------------------------- Cursors -- */
 
@@ -643,12 +648,15 @@ void EraseAndInval(Rect *r)
 {
 	GrafPtr port;
 	WindowPtr w;
+	Document *doc;
 	
 	GetPort(&port);
 	w = GetWindowFromPort(port);
 	
 	EraseRect(r);
 	InvalWindowRect(w, r);
+	if (w!=NULL && (doc = GetDocumentFromWindow(w))!=NULL)
+		InvalSysPictsInRect(doc, r);				/* Don't replay a stale System picture */
 }
 
 
@@ -1757,6 +1765,128 @@ void KludgeOS10p5LogDelay(Boolean doDelay)
 
 char inStr[1000], outStr[1000];
 
+/* LogPrintf doesn't call syslog() itself: syslog() can take long enough to wreck timing
+during playback or file I/O when there's a lot of logging. Instead it puts each complete
+line into a ring of fixed-size slots, and a background thread drains the ring into the
+system log. LogPrintf, like the rest of Nightingale, is called only from the main thread,
+so the ring has one producer and one consumer and its slots need no locks: only LogPrintf
+advances <logRingHead>, and only the drain thread advances <logRingTail>. If the ring is
+full, the line is dropped and counted, and the drain thread reports the count later. The
+drain thread sleeps on a condition variable that LogPrintf signals when it adds a line,
+and it signals another one when it's emptied the ring, for FlushLogPrintf. */
+
+#define LOG_RING_LEN 1024					/* No. of slots; must be a power of 2 */
+#define LOG_FLUSH_WAIT_MS 1000				/* Max. time FlushLogPrintf waits */
+
+typedef struct {
+	short	priLevel;
+	char	str[sizeof(outStr)];
+} LOGLINE;
+
+static LOGLINE logRing[LOG_RING_LEN];
+static volatile long logRingHead = 0L;		/* Next slot to fill; LogPrintf only */
+static volatile long logRingTail = 0L;		/* Next slot to drain; drain thread only */
+static volatile long logRingDropped = 0L;	/* Lines lost because the ring was full */
+static Boolean logDrainRunning = False;
+static pthread_mutex_t logRingMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t logRingFilled = PTHREAD_COND_INITIALIZER;	/* Ring isn't empty */
+static pthread_cond_t logRingDrained = PTHREAD_COND_INITIALIZER;	/* Ring is empty */
+
+short logLevelLimit = LOG_DEBUG;			/* Ignore messages of lower priority (higher code) */
+
+static void EnqueueLogLine(short priLevel, const char *str);
+static void DrainLogRing(void);
+static void *LogDrainThread(void *);
+
+static void EnqueueLogLine(short priLevel, const char *str)
+{
+	long head = logRingHead;
+	LOGLINE *pLine;
+	
+	if (!logDrainRunning) {									/* No thread, so do it ourselves */
+		syslog(priLevel, "%s", str);
+		return;
+	}
+	if (head-logRingTail>=LOG_RING_LEN) {
+		logRingDropped++;
+		return;
+	}
+	pLine = &logRing[head & (LOG_RING_LEN-1)];
+	pLine->priLevel = priLevel;
+	GoodStrncpy(pLine->str, (char *)str, sizeof(pLine->str)-1);
+	OSMemoryBarrier();										/* Fill the slot before publishing it */
+	logRingHead = head+1;
+
+	pthread_mutex_lock(&logRingMutex);						/* Wake up the drain thread */
+	pthread_cond_signal(&logRingFilled);
+	pthread_mutex_unlock(&logRingMutex);
+}
+
+/* Send everything waiting in the log ring to syslog(). */
+
+static void DrainLogRing()
+{
+	long head, tail, nDropped;
+	static long nDroppedReported = 0L;
+	
+	head = logRingHead;
+	OSMemoryBarrier();										/* Don't read slots before <head> */
+	for (tail = logRingTail; tail!=head; tail++) {
+		LOGLINE *pLine = &logRing[tail & (LOG_RING_LEN-1)];
+		syslog(pLine->priLevel, "%s", pLine->str);
+	}
+	OSMemoryBarrier();										/* Done with the slots before freeing them */
+	logRingTail = tail;
+
+	nDropped = logRingDropped;
+	if (nDropped!=nDroppedReported) {
+		syslog(LOG_WARNING, "Warning. %ld log messages were lost because the log ring was full.  (DrainLogRing)\n",
+					nDropped-nDroppedReported);
+		nDroppedReported = nDropped;
+	}
+}
+
+static void *LogDrainThread(void * /* arg */)
+{
+	while (True) {
+		pthread_mutex_lock(&logRingMutex);
+		while (logRingTail==logRingHead)
+			pthread_cond_wait(&logRingFilled, &logRingMutex);
+		pthread_mutex_unlock(&logRingMutex);
+
+		DrainLogRing();
+
+		pthread_mutex_lock(&logRingMutex);
+		if (logRingTail==logRingHead) pthread_cond_broadcast(&logRingDrained);
+		pthread_mutex_unlock(&logRingMutex);
+	}
+	return NULL;
+}
+
+/* Wait (but not forever) until the drain thread has sent everything in the log ring to
+syslog(). Call before quitting, and after anything that might be followed by a crash. */
+
+void FlushLogPrintf()
+{
+	struct timeval now;
+	struct timespec deadline;
+
+	if (!logDrainRunning) return;
+	
+	gettimeofday(&now, NULL);
+	deadline.tv_sec = now.tv_sec+LOG_FLUSH_WAIT_MS/1000;
+	deadline.tv_nsec = (now.tv_usec+1000L*(LOG_FLUSH_WAIT_MS%1000))*1000L;
+	if (deadline.tv_nsec>=1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&logRingMutex);
+	while (logRingTail!=logRingHead)
+		if (pthread_cond_timedwait(&logRingDrained, &logRingMutex, &deadline)!=0) break;
+	pthread_mutex_unlock(&logRingMutex);
+}
+
 Boolean VLogPrintf(const char *fmt, va_list argp)
 {
 	//if (strlen(inStr)+strlen(str)>=1000) return False;	FIXME: How to check for buffer overflow?
@@ -1791,7 +1921,10 @@ const char *NameLogLevel(
  following parameters. The message may contain at most one "\n". There are two cases:
  (1) It may be terminated by "\n", i.e., it may be a full line or a chunk ending a line.
  (2) If it's not terminated by "\n", it's a partial line, to be completed on a later call.
- In case #1, we send the complete line to syslog(); in case #2, just add it to a buffer.
+ In case #1, we queue the complete line for syslog(); in case #2, just add it to a buffer.
+ Messages with a priority lower than <logLevelLimit> are ignored; to avoid even evaluating
+ their arguments, use the LOGPRINTF macro instead of calling this directly. Messages of
+ priority LOG_ERR or higher are flushed to the log immediately, in case a crash follows.
  FIXME: Instances of "\n" other than at the end of the message aren't handled correctly! */
 
 Boolean LogPrintf(short priLevel, const char *fmt, ...)
@@ -1800,6 +1933,7 @@ Boolean LogPrintf(short priLevel, const char *fmt, ...)
 	const char *ps;
 	char levelStr[32];
 		
+	if (!LOG_LEVEL_ON(priLevel)) return True;
 	if (addLogMsgDelay) SleepMS(3);
 
 	/* If we're starting a new line, prefix a code for the level. */
@@ -1821,7 +1955,8 @@ Boolean LogPrintf(short priLevel, const char *fmt, ...)
 	strcat(outStr, inStr);
 	endLine = (inStr[strlen(inStr)-1]=='\n');
 	if (endLine) {
-		syslog(priLevel, outStr);
+		EnqueueLogLine(priLevel, outStr);
+		if (priLevel<=LOG_ERR) FlushLogPrintf();
 		outStr[0] = '\0';									/* Set <outStr> to empty */
 	}
 	
@@ -1829,6 +1964,33 @@ Boolean LogPrintf(short priLevel, const char *fmt, ...)
 }
 
 
+/* Support for LOGPRINTF_LIMITED: return True if the call site whose state is *<pRate>
+can log another message now, i.e., if it hasn't already logged LOG_RATE_MAX messages
+in the last second. When the site starts a new second after having messages suppressed,
+log how many were. */
+
+Boolean LogRateOK(LOGRATE *pRate)
+{
+	unsigned long now = TickCount();
+	
+	if (now-pRate->windowStart>=60L) {
+		if (pRate->nSuppressed>0L && strlen(outStr)==0) {
+			LogPrintf(LOG_NOTICE, "%ld similar messages were suppressed.  (LogRateOK)\n",
+						pRate->nSuppressed);
+			pRate->nSuppressed = 0L;
+		}
+		pRate->windowStart = now;
+		pRate->nInWindow = 0;
+	}
+	if (pRate->nInWindow>=LOG_RATE_MAX) {
+		pRate->nSuppressed++;
+		return False;
+	}
+	pRate->nInWindow++;
+	return True;
+}
+
+
 #define NoTEST_LOGGING_FUNCS
 #define NoTEST_LOGGING_LEVELS
 
@@ -1840,6 +2002,14 @@ short InitLogPrintf()
 	
 	int oldLevelMask = setlogmask(LOG_UPTO(LOG_DEBUG));
 	outStr[0] = '\0';										/* Set <outStr> to empty */
+
+	pthread_t drainThread;
+	if (pthread_create(&drainThread, NULL, LogDrainThread, NULL)==0) {
+		pthread_detach(drainThread);
+		logDrainRunning = True;
+	}
+	else
+		syslog(LOG_WARNING, "Warning. Can't start the log drain thread; logging synchronously.  (InitLogPrintf)\n");
 	
 #ifdef TEST_LOGGING_FUNCS
 	LogPrintf(LOG_INFO, "A simple one-line LogPrintf.\n");